@@ -0,0 +1,288 @@
+// emu.c — GraphX/FontLib/FileIOC/TICE de mentira p/ rodar o viewer no PC
+// Desenha de verdade num framebuffer 320x240 de 8 bits (dois buffers), p/ que
+// o custo por frame inclua o trabalho de pixel e não só a lógica do viewer.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <graphx.h>
+#include <fontlibc.h>
+#include <fileioc.h>
+#include <tice.h>
+
+#include "emu.h"
+
+#define LCD_W 320
+#define LCD_H 240
+
+/* ---------------------- GraphX ---------------------- */
+
+static uint8_t g_vram[2][LCD_H][LCD_W];
+static int g_back = 1;                     // buffer onde se desenha
+static uint8_t g_color = 0, g_tfg = 0, g_tbg = 255, g_ttr = 255, g_str = 0;
+static int g_cx0 = 0, g_cy0 = 0, g_cx1 = LCD_W, g_cy1 = LCD_H;
+static int g_tx = 0, g_ty = 0;
+static unsigned g_swaps = 0;
+
+static void plot(int x, int y, uint8_t c){
+    if (x >= g_cx0 && x < g_cx1 && y >= g_cy0 && y < g_cy1) g_vram[g_back][y][x] = c;
+}
+
+void gfx_Begin(void){ memset(g_vram, 255, sizeof g_vram); }
+void gfx_End(void){}
+void gfx_SetDrawBuffer(void){ g_back = 1; }
+void gfx_SwapDraw(void){ g_back ^= 1; g_swaps++; }
+
+uint8_t gfx_SetColor(uint8_t c){ uint8_t o = g_color; g_color = c; return o; }
+uint8_t gfx_SetTextFGColor(uint8_t c){ uint8_t o = g_tfg; g_tfg = c; return o; }
+uint8_t gfx_SetTextBGColor(uint8_t c){ uint8_t o = g_tbg; g_tbg = c; return o; }
+uint8_t gfx_SetTextTransparentColor(uint8_t c){ uint8_t o = g_ttr; g_ttr = c; return o; }
+uint8_t gfx_SetTransparentColor(uint8_t c){ uint8_t o = g_str; g_str = c; return o; }
+
+void gfx_SetClipRegion(int xmin, int ymin, int xmax, int ymax){
+    g_cx0 = xmin < 0 ? 0 : xmin;  g_cy0 = ymin < 0 ? 0 : ymin;
+    g_cx1 = xmax > LCD_W ? LCD_W : xmax;  g_cy1 = ymax > LCD_H ? LCD_H : ymax;
+}
+
+void gfx_FillScreen(uint8_t c){ memset(g_vram[g_back], c, sizeof g_vram[0]); }
+
+void gfx_Line(int x0, int y0, int x1, int y1){
+    int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+    int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+    for (;;) {
+        plot(x0, y0, g_color);
+        if (x0 == x1 && y0 == y1) break;
+        int e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x0 += sx; }
+        if (e2 <= dx) { err += dx; y0 += sy; }
+    }
+}
+
+gfx_sprite_t *gfx_MallocSprite(uint8_t w, uint8_t h){
+    gfx_sprite_t *s = (gfx_sprite_t*)malloc(sizeof(gfx_sprite_t) + (size_t)w * h);
+    if (s) { s->width = w; s->height = h; }
+    return s;
+}
+
+// como na GraphX: o sprite é recortado pela região de clip
+void gfx_TransparentSprite(const gfx_sprite_t *s, int x, int y){
+    const uint8_t *p = s->data;
+    for (int r = 0; r < s->height; ++r)
+        for (int c = 0; c < s->width; ++c, ++p)
+            if (*p != g_str) plot(x + c, y + r, *p);
+}
+
+// fonte padrão da GraphX: 8x8; aqui um padrão fixo por caractere
+void gfx_SetTextXY(int x, int y){ g_tx = x; g_ty = y; }
+void gfx_PrintChar(const char ch){
+    uint8_t c = (uint8_t)ch;
+    for (int r = 0; r < 8; ++r) {
+        uint8_t bits = (uint8_t)(c * 37u + r * 11u);
+        for (int k = 0; k < 8; ++k) {
+            if (bits & (0x80 >> k)) plot(g_tx + k, g_ty + r, g_tfg);
+            else if (g_tbg != g_ttr) plot(g_tx + k, g_ty + r, g_tbg);
+        }
+    }
+    g_tx += 8;
+}
+void gfx_PrintString(const char *s){ while (*s) gfx_PrintChar(*s++); }
+void gfx_PrintStringXY(const char *s, int x, int y){ gfx_SetTextXY(x, y); gfx_PrintString(s); }
+void gfx_PrintUInt(unsigned int n, uint8_t length){
+    char buf[12];
+    int k = 0;
+    do { buf[k++] = (char)('0' + n % 10); n /= 10; } while (n && k < 11);
+    while (k < length && k < 11) buf[k++] = '0';
+    while (k) gfx_PrintChar(buf[--k]);
+}
+
+/* ---------------------- FontLib ---------------------- */
+
+// Fonte de teste embutida: larguras parecidas com a fonte do SO (estreitas,
+// largas, resto 6px) e glifos gerados por fórmula, p/ resultados repetíveis.
+#define FONT_H 12
+static uint8_t g_widths[256];
+static uint16_t g_bitmap[256][FONT_H];
+static fontlib_font_t g_testfont;
+static const fontlib_font_t *g_font;
+static uint8_t g_ffg = 0, g_fbg = 255;
+static int g_ftransp = 1;
+static unsigned g_fx = 0, g_fy = 0;
+
+static void font_init(void){
+    for (int c = 0; c < 256; ++c) {
+        uint8_t w = 6;
+        if (c == ' ' || strchr("il.,:;'|!", c)) w = 3;
+        else if (strchr("mwMW@", c) || c >= 0x80) w = 8;
+        g_widths[c] = w;
+        for (int r = 0; r < FONT_H; ++r)
+            g_bitmap[c][r] = (r < 2 || r >= FONT_H - 2 || c == ' ') ? 0
+                           : (uint16_t)((c * 2654435761u >> (r + 7)) & ((1u << (w - 1)) - 1));
+    }
+    g_testfont.fontVersion = 0;
+    g_testfont.height = FONT_H;
+    g_testfont.total_glyphs = 0;           // 0 = 256 na FontLib
+    g_testfont.first_glyph = 0;
+    g_testfont.widths_table = g_widths;
+    g_testfont.bitmaps_table = g_bitmap;
+    g_testfont.space_above = 0;
+    g_testfont.space_below = 2;
+    g_testfont.baseline_height = 9;
+}
+
+fontlib_font_t *fontlib_GetFontByIndex(const char *pack, uint8_t index){
+    (void)pack;
+    if (index) return NULL;
+    if (!g_testfont.height) font_init();
+    return &g_testfont;
+}
+
+bool fontlib_SetFont(const fontlib_font_t *f, int flags){ (void)flags; g_font = f; return f != NULL; }
+void fontlib_SetForegroundColor(uint8_t c){ g_ffg = c; }
+void fontlib_SetBackgroundColor(uint8_t c){ g_fbg = c; }
+void fontlib_SetTransparency(bool t){ g_ftransp = t; }
+
+uint8_t fontlib_GetGlyphWidth(char cp){ return g_font->widths_table[(uint8_t)cp]; }
+
+unsigned int fontlib_GetStringWidth(const char *s){
+    unsigned w = 0;
+    while (*s) w += fontlib_GetGlyphWidth(*s++);
+    return w;
+}
+
+void fontlib_SetCursorPosition(unsigned int x, uint8_t y){ g_fx = x; g_fy = y; }
+
+// a FontLib não recorta por pixel fora da janela; o viewer já recorta por glifo
+unsigned int fontlib_DrawStringL(const char *s, size_t max){
+    for (size_t i = 0; i < max && s[i]; ++i) {
+        uint8_t c = (uint8_t)s[i];
+        uint8_t w = g_font->widths_table[c];
+        for (int r = 0; r < FONT_H; ++r) {
+            uint16_t bits = g_bitmap[c][r];
+            int y = (int)g_fy + r;
+            if (y >= LCD_H) break;
+            for (int k = 0; k < w; ++k) {
+                int x = (int)g_fx + k;
+                if (x >= LCD_W) break;
+                if (bits & (1u << k)) g_vram[g_back][y][x] = g_ffg;
+                else if (!g_ftransp) g_vram[g_back][y][x] = g_fbg;
+            }
+        }
+        g_fx += w;
+    }
+    return g_fx;
+}
+
+/* ---------------------- FileIOC ---------------------- */
+
+// AppVars vivem em memória; o lvhost carrega/grava os arquivos do PC
+#define MAX_VARS 8
+#define MAX_OPEN 4
+typedef struct { char name[9]; uint8_t *data; size_t size; } Var;
+typedef struct { Var *v; size_t pos; int wr; } Slot;
+static Var g_vars[MAX_VARS];
+static Slot g_slots[MAX_OPEN + 1];         // handle 0 = falha
+
+static Var *var_find(const char *name, int create){
+    Var *free_v = NULL;
+    for (int i = 0; i < MAX_VARS; ++i) {
+        if (g_vars[i].name[0] && strncmp(g_vars[i].name, name, 8) == 0) return &g_vars[i];
+        if (!g_vars[i].name[0] && !free_v) free_v = &g_vars[i];
+    }
+    if (!create || !free_v) return NULL;
+    snprintf(free_v->name, sizeof free_v->name, "%s", name);
+    return free_v;
+}
+
+void emu_var_set(const char *name, const void *data, size_t n){
+    Var *v = var_find(name, 1);
+    if (!v) return;
+    free(v->data);
+    v->data = (uint8_t*)malloc(n ? n : 1);
+    memcpy(v->data, data, n);
+    v->size = n;
+}
+
+const uint8_t *emu_var_get(const char *name, size_t *n){
+    Var *v = var_find(name, 0);
+    if (!v) return NULL;
+    *n = v->size;
+    return v->data;
+}
+
+ti_var_t ti_Open(const char *name, const char *mode){
+    int wr = mode[0] == 'w' || mode[0] == 'a' || mode[1] == '+';
+    Var *v = var_find(name, mode[0] != 'r');
+    if (!v) return 0;
+    if (mode[0] == 'w') v->size = 0;
+    for (int h = 1; h <= MAX_OPEN; ++h) {
+        if (g_slots[h].v) continue;
+        g_slots[h].v = v;
+        g_slots[h].pos = mode[0] == 'a' ? v->size : 0;
+        g_slots[h].wr = wr;
+        return (ti_var_t)h;
+    }
+    return 0;
+}
+
+int ti_Close(ti_var_t h){
+    if (h < 1 || h > MAX_OPEN) return 0;
+    g_slots[h].v = NULL;
+    return 1;
+}
+
+size_t ti_GetSize(ti_var_t h){ return g_slots[h].v ? g_slots[h].v->size : 0; }
+
+size_t ti_Read(void *data, size_t size, size_t count, ti_var_t h){
+    Slot *s = &g_slots[h];
+    if (!s->v || !size) return 0;
+    size_t n = (s->v->size - s->pos) / size;
+    if (n > count) n = count;
+    memcpy(data, s->v->data + s->pos, n * size);
+    s->pos += n * size;
+    return n;
+}
+
+size_t ti_Write(const void *data, size_t size, size_t count, ti_var_t h){
+    Slot *s = &g_slots[h];
+    if (!s->v || !s->wr || !size) return 0;
+    size_t end = s->pos + size * count;
+    if (end > 0xFFEB) return 0;            // limite de uma AppVar na CE
+    if (end > s->v->size) {
+        s->v->data = (uint8_t*)realloc(s->v->data, end);
+        s->v->size = end;
+    }
+    memcpy(s->v->data + s->pos, data, size * count);
+    s->pos = end;
+    return count;
+}
+
+/* ---------------------- TICE ---------------------- */
+
+// não dorme: só avança o relógio virtual (ms) que o clock() do viewer lê
+static unsigned long g_slept_ms = 0;
+void delay(uint16_t ms){ g_slept_ms += ms; }
+
+#undef clock
+clock_t emu_clock(void){ return (clock_t)((unsigned long long)g_slept_ms * CLOCKS_PER_SEC / 1000); }
+
+// o PC não muda de clock: só conta as trocas p/ 6 MHz
+static unsigned g_slowdowns = 0;
+void boot_Set6MHzMode(void){ g_slowdowns++; }
+void boot_Set48MHzMode(void){}
+
+/* ---------------------- Consultas do lvhost ---------------------- */
+
+unsigned emu_swaps(void){ return g_swaps; }
+unsigned long emu_slept_ms(void){ return g_slept_ms; }
+unsigned emu_slowdowns(void){ return g_slowdowns; }
+
+// último frame mostrado, em PGM (tons de cinza = índice da paleta)
+int emu_dump_pgm(const char *path){
+    FILE *f = fopen(path, "wb");
+    if (!f) return 0;
+    fprintf(f, "P5\n%d %d\n255\n", LCD_W, LCD_H);
+    fwrite(g_vram[g_back ^ 1], 1, sizeof g_vram[0], f);
+    fclose(f);
+    return 1;
+}
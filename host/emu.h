@@ -0,0 +1,16 @@
+// emu.h — o que o lvhost consulta/controla no emu.c
+#ifndef HOST_EMU_H
+#define HOST_EMU_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+void emu_var_set(const char *name, const void *data, size_t n);
+const uint8_t *emu_var_get(const char *name, size_t *n);
+
+unsigned emu_swaps(void);              // gfx_SwapDraw chamados até agora
+unsigned long emu_slept_ms(void);      // soma dos delay() pedidos
+unsigned emu_slowdowns(void);          // vezes que o viewer baixou p/ 6 MHz
+int emu_dump_pgm(const char *path);    // último frame mostrado
+
+#endif
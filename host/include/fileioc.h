@@ -0,0 +1,16 @@
+// fileioc.h (host) — AppVars em memória; ver host/emu.c
+#ifndef HOST_FILEIOC_H
+#define HOST_FILEIOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint8_t ti_var_t;
+
+ti_var_t ti_Open(const char *name, const char *mode);
+int ti_Close(ti_var_t handle);
+size_t ti_GetSize(ti_var_t handle);
+size_t ti_Read(void *data, size_t size, size_t count, ti_var_t handle);
+size_t ti_Write(const void *data, size_t size, size_t count, ti_var_t handle);
+
+#endif
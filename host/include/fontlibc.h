@@ -0,0 +1,37 @@
+// fontlibc.h (host) — fonte de teste embutida; ver host/emu.c
+#ifndef HOST_FONTLIBC_H
+#define HOST_FONTLIBC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    uint8_t fontVersion;
+    uint8_t height;
+    uint8_t total_glyphs;
+    uint8_t first_glyph;
+    const uint8_t *widths_table;
+    const void *bitmaps_table;
+    uint8_t italic_space_adjust;
+    uint8_t space_above;
+    uint8_t space_below;
+    uint8_t weight;
+    uint8_t style;
+    uint8_t cap_height;
+    uint8_t x_height;
+    uint8_t baseline_height;
+} fontlib_font_t;
+
+fontlib_font_t *fontlib_GetFontByIndex(const char *font_pack_name, uint8_t index);
+bool fontlib_SetFont(const fontlib_font_t *font_data, int flags);
+void fontlib_SetForegroundColor(uint8_t color);
+void fontlib_SetBackgroundColor(uint8_t color);
+void fontlib_SetTransparency(bool transparency);
+
+uint8_t fontlib_GetGlyphWidth(char codepoint);
+unsigned int fontlib_GetStringWidth(const char *str);
+void fontlib_SetCursorPosition(unsigned int x, uint8_t y);
+unsigned int fontlib_DrawStringL(const char *str, size_t max_characters);
+
+#endif
@@ -0,0 +1,37 @@
+// graphx.h (host) — só o que o viewer usa; ver host/emu.c
+#ifndef HOST_GRAPHX_H
+#define HOST_GRAPHX_H
+
+#include <stdint.h>
+
+typedef struct {
+    uint8_t width;
+    uint8_t height;
+    uint8_t data[];
+} gfx_sprite_t;
+
+void gfx_Begin(void);
+void gfx_End(void);
+void gfx_SetDrawBuffer(void);
+void gfx_SwapDraw(void);
+
+uint8_t gfx_SetColor(uint8_t index);
+uint8_t gfx_SetTextFGColor(uint8_t color);
+uint8_t gfx_SetTextBGColor(uint8_t color);
+uint8_t gfx_SetTextTransparentColor(uint8_t color);
+uint8_t gfx_SetTransparentColor(uint8_t index);
+void gfx_SetClipRegion(int xmin, int ymin, int xmax, int ymax);
+
+void gfx_FillScreen(uint8_t index);
+void gfx_Line(int x0, int y0, int x1, int y1);
+
+gfx_sprite_t *gfx_MallocSprite(uint8_t width, uint8_t height);
+void gfx_TransparentSprite(const gfx_sprite_t *sprite, int x, int y);
+
+void gfx_SetTextXY(int x, int y);
+void gfx_PrintChar(const char c);
+void gfx_PrintString(const char *string);
+void gfx_PrintStringXY(const char *string, int x, int y);
+void gfx_PrintUInt(unsigned int n, uint8_t length);
+
+#endif
@@ -0,0 +1,24 @@
+// keypadc.h (host) — teclado dirigido pelo script do lvhost
+#ifndef HOST_KEYPADC_H
+#define HOST_KEYPADC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+extern uint8_t kb_Data[8];
+extern bool kb_On;
+
+// grupo 1
+#define kb_Mode   (1 << 6)
+// grupo 7
+#define kb_Down   (1 << 0)
+#define kb_Left   (1 << 1)
+#define kb_Right  (1 << 2)
+#define kb_Up     (1 << 3)
+
+void kb_Scan(void);
+void kb_EnableOnLatch(void);
+void kb_DisableOnLatch(void);
+void kb_ClearOnLatch(void);
+
+#endif
@@ -0,0 +1,18 @@
+// tice.h (host) — só o que o viewer usa; ver host/emu.c
+#ifndef HOST_TICE_H
+#define HOST_TICE_H
+
+#include <stdint.h>
+#include <time.h>
+
+void delay(uint16_t msec);
+
+// clock() do viewer lê um relógio virtual que só o delay() avança: a janela
+// de 1 s do overlay fecha igual em qualquer PC e a rodada é repetível.
+// (time.h já foi incluído acima, então a declaração da libc não é afetada.)
+clock_t emu_clock(void);
+#define clock emu_clock
+void boot_Set6MHzMode(void);
+void boot_Set48MHzMode(void);
+
+#endif
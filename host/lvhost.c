@@ -0,0 +1,301 @@
+// lvhost.c — roda o viewer (src/main.c) no PC contra um roteiro de teclas e
+// mede cada volta do loop principal: ciclos e instruções por frame.
+// Uso: lvhost [-c cache.bin] [-p frame.pgm] [-q] doc.bin roteiro.txt
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include <keypadc.h>
+#include "emu.h"
+
+// mesmo nome que o viewer abre (ver DOC_NAME em src/main.c)
+#ifndef DOC_NAME
+#define DOC_NAME DOC1
+#endif
+#define _S2(x) #x
+#define _S1(x) _S2(x)
+#define DOC_NAME_STR _S1(DOC_NAME)
+
+int viewer_main(void);                 // src/main.c compilado com -Dmain=viewer_main
+
+/* ---------------------- Contadores ---------------------- */
+
+// ciclos: perf (ciclos reais do núcleo) > rdtsc > clock_gettime (ns)
+// instruções: só com perf; sem ele o relatório mostra "n/d"
+static int g_fd_cyc = -1, g_fd_ins = -1;
+static const char *g_cyc_unit = "ns";
+
+#ifdef __linux__
+static int perf_open(uint64_t config){
+    struct perf_event_attr a;
+    memset(&a, 0, sizeof a);
+    a.type = PERF_TYPE_HARDWARE;
+    a.size = sizeof a;
+    a.config = config;
+    a.exclude_kernel = 1;
+    a.exclude_hv = 1;
+    int fd = (int)syscall(SYS_perf_event_open, &a, 0, -1, -1, 0);
+    if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    return fd;
+}
+
+static uint64_t perf_read(int fd){
+    uint64_t x = 0;
+    if (read(fd, &x, sizeof x) != (ssize_t)sizeof x) x = 0;
+    return x;
+}
+#endif
+
+static void counters_init(int use_perf){
+#ifdef __linux__
+    if (use_perf) {
+        g_fd_cyc = perf_open(PERF_COUNT_HW_CPU_CYCLES);
+        g_fd_ins = perf_open(PERF_COUNT_HW_INSTRUCTIONS);
+    }
+#else
+    (void)use_perf;
+#endif
+    if (g_fd_cyc >= 0) g_cyc_unit = "ciclos";
+#if defined(__x86_64__) || defined(__i386__)
+    else g_cyc_unit = "ciclos TSC";
+#endif
+}
+
+typedef struct { uint64_t cyc, ins; } Sample;
+
+static Sample sample(void){
+    Sample s = { 0, 0 };
+#ifdef __linux__
+    if (g_fd_cyc >= 0) s.cyc = perf_read(g_fd_cyc);
+    if (g_fd_ins >= 0) s.ins = perf_read(g_fd_ins);
+    if (g_fd_cyc >= 0) return s;
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+    s.cyc = __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    s.cyc = (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+    return s;
+}
+
+/* ---------------------- Roteiro ---------------------- */
+
+// Cada linha: <comando> [N]. Um toque = um scan com a tecla + um sem,
+// porque o viewer só reage à borda de descida.
+//   down N | up N | left N | right N | mode N   (N toques, padrão 1)
+//   idle N                                      (N scans sem tecla)
+//   on                                          (sai; implícito no fim)
+typedef struct { uint8_t g1, g7, on; int line; } Step;
+static Step *g_steps = NULL;
+static size_t g_nsteps = 0, g_cap = 0, g_pos = 0;
+
+static void push(uint8_t g1, uint8_t g7, uint8_t on, int line){
+    if (g_nsteps == g_cap) {
+        g_cap = g_cap ? g_cap * 2 : 256;
+        g_steps = (Step*)realloc(g_steps, g_cap * sizeof(Step));
+    }
+    g_steps[g_nsteps].g1 = g1; g_steps[g_nsteps].g7 = g7;
+    g_steps[g_nsteps].on = on; g_steps[g_nsteps].line = line;
+    g_nsteps++;
+}
+
+static int load_script(const char *path){
+    FILE *f = fopen(path, "r");
+    if (!f) { perror(path); return 0; }
+    static const struct { const char *cmd; uint8_t g1, g7; } keys[] = {
+        { "down", 0, kb_Down }, { "up", 0, kb_Up }, { "left", 0, kb_Left },
+        { "right", 0, kb_Right }, { "mode", kb_Mode, 0 }, { "idle", 0, 0 },
+    };
+    char buf[128], cmd[32];
+    int line = 0, ok = 1;
+    while (fgets(buf, sizeof buf, f)) {
+        line++;
+        char *h = strchr(buf, '#'); if (h) *h = 0;
+        long n = 1;
+        int got = sscanf(buf, "%31s %ld", cmd, &n);
+        if (got < 1) continue;
+        if (n < 0) n = 0;
+        if (strcmp(cmd, "on") == 0) { push(0, 0, 1, line); break; }
+        size_t k = 0;
+        while (k < sizeof keys / sizeof keys[0] && strcmp(cmd, keys[k].cmd) != 0) k++;
+        if (k == sizeof keys / sizeof keys[0]) {
+            fprintf(stderr, "%s:%d: comando desconhecido '%s'\n", path, line, cmd);
+            ok = 0;
+            continue;
+        }
+        for (long i = 0; i < n; ++i) {
+            if (keys[k].g1 || keys[k].g7) push(keys[k].g1, keys[k].g7, 0, line);
+            push(0, 0, 0, line);
+        }
+    }
+    fclose(f);
+    if (!g_nsteps || !g_steps[g_nsteps - 1].on) push(0, 0, 1, line);
+    return ok;
+}
+
+/* ---------------------- Teclado + medição ---------------------- */
+
+uint8_t kb_Data[8];
+bool kb_On = false;
+
+typedef struct { uint64_t cyc, ins; int drew, line; } Frame;
+static Frame *g_frames = NULL;
+static size_t g_nframes = 0;
+static Sample g_last, g_start;
+static unsigned g_last_swaps = 0;
+static int g_started = 0;
+
+// fecha a volta anterior do loop (de um kb_Scan ao próximo)
+void kb_Scan(void){
+    Sample now = sample();
+    if (!g_started) {
+        g_start.cyc = now.cyc - g_last.cyc;          // inicialização do viewer
+        g_start.ins = now.ins - g_last.ins;
+        g_started = 1;
+    } else if (g_nframes <= g_nsteps) {
+        Frame *fr = &g_frames[g_nframes++];
+        fr->cyc = now.cyc - g_last.cyc;
+        fr->ins = now.ins - g_last.ins;
+        fr->drew = emu_swaps() != g_last_swaps;
+        fr->line = g_pos ? g_steps[g_pos - 1].line : 0;
+    }
+    g_last_swaps = emu_swaps();
+
+    const Step *s = &g_steps[g_pos < g_nsteps ? g_pos : g_nsteps - 1];
+    if (g_pos < g_nsteps) g_pos++;
+    memset(kb_Data, 0, sizeof kb_Data);
+    kb_Data[1] = s->g1;
+    kb_Data[7] = s->g7;
+    kb_On = s->on;
+    g_last = sample();                               // não conta o roteiro
+}
+
+void kb_EnableOnLatch(void){}
+void kb_DisableOnLatch(void){}
+void kb_ClearOnLatch(void){}
+
+/* ---------------------- Relatório ---------------------- */
+
+static int cmp_u64(const void *a, const void *b){
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void summary(const char *label, int drew){
+    uint64_t *c = (uint64_t*)malloc((g_nframes + 1) * sizeof(uint64_t));
+    uint64_t ins = 0, cyc = 0;
+    size_t n = 0;
+    for (size_t i = 0; i < g_nframes; ++i) {
+        if (g_frames[i].drew != drew) continue;
+        c[n++] = g_frames[i].cyc;
+        cyc += g_frames[i].cyc;
+        ins += g_frames[i].ins;
+    }
+    if (!n) { printf("  %-9s %6d\n", label, 0); free(c); return; }
+    qsort(c, n, sizeof(uint64_t), cmp_u64);
+    printf("  %-9s %6zu %12llu %12llu %12llu %12llu", label, n,
+           (unsigned long long)c[0], (unsigned long long)(cyc / n),
+           (unsigned long long)c[n * 95 / 100], (unsigned long long)c[n - 1]);
+    if (g_fd_ins >= 0) printf(" %12llu\n", (unsigned long long)(ins / n));
+    else printf(" %12s\n", "n/d");
+    free(c);
+}
+
+static uint8_t *read_file(const char *path, size_t *n){
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END); long sz = ftell(f); rewind(f);
+    uint8_t *buf = (uint8_t*)malloc(sz > 0 ? (size_t)sz : 1);
+    *n = fread(buf, 1, sz > 0 ? (size_t)sz : 0, f);
+    fclose(f);
+    return buf;
+}
+
+int main(int argc, char **argv){
+    const char *cache = NULL, *pgm = NULL, *doc = NULL, *script = NULL;
+    int quiet = 0, use_perf = 1;
+    for (int a = 1; a < argc; ++a) {
+        if (strcmp(argv[a], "-c") == 0 && a + 1 < argc) cache = argv[++a];
+        else if (strcmp(argv[a], "-p") == 0 && a + 1 < argc) pgm = argv[++a];
+        else if (strcmp(argv[a], "-q") == 0) quiet = 1;
+        else if (strcmp(argv[a], "-r") == 0) use_perf = 0;
+        else if (!doc) doc = argv[a];
+        else script = argv[a];
+    }
+    if (!doc || !script) {
+        fprintf(stderr, "uso: %s [-c cache.bin] [-p frame.pgm] [-q] [-r] doc.bin roteiro.txt\n"
+                        "  -c  carrega/grava a AppVar de cache (%sc) nesse arquivo\n"
+                        "  -p  grava o ultimo frame mostrado em PGM\n"
+                        "  -q  so o resumo, sem a linha de cada frame\n"
+                        "  -r  nao usa perf_event_open (so rdtsc/clock_gettime)\n",
+                argv[0], DOC_NAME_STR);
+        return 1;
+    }
+
+    size_t n;
+    uint8_t *buf = read_file(doc, &n);
+    if (!buf) { perror(doc); return 1; }
+    emu_var_set(DOC_NAME_STR, buf, n);
+    free(buf);
+
+    char cname[9];
+    snprintf(cname, sizeof cname, "%.7sc", DOC_NAME_STR);
+    if (cache && (buf = read_file(cache, &n))) { emu_var_set(cname, buf, n); free(buf); }
+
+    if (!load_script(script)) return 1;
+    g_frames = (Frame*)calloc(g_nsteps + 1, sizeof(Frame));
+
+    counters_init(use_perf);
+    g_last = sample();
+    int rc = viewer_main();
+    Sample end = sample();
+    uint64_t exit_cyc = end.cyc - g_last.cyc, exit_ins = end.ins - g_last.ins;
+
+    if (cache) {
+        const uint8_t *c = emu_var_get(cname, &n);
+        FILE *f = c ? fopen(cache, "wb") : NULL;
+        if (f) { fwrite(c, 1, n, f); fclose(f); }
+    }
+    if (pgm && !emu_dump_pgm(pgm)) perror(pgm);
+
+    if (!quiet) {
+        printf("%6s %5s %12s %12s  %s\n", "frame", "linha", g_cyc_unit, "instrucoes", "");
+        for (size_t i = 0; i < g_nframes; ++i) {
+            if (!g_frames[i].drew) continue;
+            printf("%6zu %5d %12llu ", i, g_frames[i].line, (unsigned long long)g_frames[i].cyc);
+            if (g_fd_ins >= 0) printf("%12llu\n", (unsigned long long)g_frames[i].ins);
+            else printf("%12s\n", "n/d");
+        }
+        printf("\n");
+    }
+
+    printf("%s + %s: %zu voltas do loop, %u frames desenhados, %lu ms de delay() pedidos, %u vezes a 6 MHz\n",
+           doc, script, g_nframes, emu_swaps(), emu_slept_ms(), emu_slowdowns());
+    printf("contador: %s%s\n\n", g_cyc_unit, g_fd_ins >= 0 ? " + instrucoes (perf)" : ", instrucoes n/d (sem perf)");
+    printf("  %-9s %12s %12s\n", "", g_cyc_unit, "instrucoes");
+    printf("  %-9s %12llu ", "inicio", (unsigned long long)g_start.cyc);
+    if (g_fd_ins >= 0) printf("%12llu\n", (unsigned long long)g_start.ins); else printf("%12s\n", "n/d");
+    printf("  %-9s %12llu ", "saida", (unsigned long long)exit_cyc);
+    if (g_fd_ins >= 0) printf("%12llu\n\n", (unsigned long long)exit_ins); else printf("%12s\n\n", "n/d");
+    printf("  %-9s %6s %12s %12s %12s %12s %12s\n", "voltas", "n", "min", "media", "p95", "max", "instr/media");
+    summary("desenho", 1);
+    summary("ociosas", 0);
+
+    free(g_frames); free(g_steps);
+    return rc;
+}
@@ -7,6 +7,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <fontlibc.h>
+#include <time.h>
 
 typedef uint8_t  u8;
 typedef uint16_t u16;
@@ -19,12 +20,23 @@ static fontlib_font_t *g_font = NULL;
 #define SUB_SHIFT 6   // coloca o subscrito 6px abaixo do topo da linha
 #define FRAC_GAP 2
 #define FRAC_BAR 2
+#define PAN_STEP  16  // passo do pan horizontal (setas esq/dir)
+#define IDLE_MS   20  // ocioso: espera entre leituras do teclado
+#define RAD_W     7   // largura do "v" do radical
+#define RAD_TOP   3   // conteudo da raiz desce 3px (traco de cima + folga)
+#define MAT_CGAP  6   // espaco entre colunas da matriz
+#define MAT_RGAP  2   // espaco entre linhas da matriz
+#define MAT_DELIM 4   // largura de cada delimitador ( [ |
 #define TAG_TEXT   0x01
 #define TAG_FRAC   0x02
 #define TAG_SUP    0x03
 #define TAG_SUB    0x04
 #define TAG_NL     0x05
 #define TAG_PAR    0x06
+#define TAG_SQRT   0x07
+#define TAG_MAT    0x08
+#define TAG_BIGOP  0x09
+#define TAG_GLYPH  0x0A
 #define TAG_END    0xFF
 
 // DOC_NAME chega como token (ex.: EX1LAMB) e aqui viramos "EX1LAMB"
@@ -52,14 +64,62 @@ typedef struct Node Node;
 struct Node {
     u8 tag;
     char *text;      // TEXT
-    Node *num, *den; // FRAC
-    Node *child;     // SUP/SUB
+    Node *num, *den; // FRAC; BIGOP: limite de cima/baixo
+    Node *child;     // SUP/SUB/SQRT; BIGOP: o operador
     Node *next;      // sequência
     int w,h;         // medidas calculadas
+    Node **cell;     // MAT: rows*cols sequencias (linha a linha)
+    int *colw, *rowh;// MAT: largura por coluna / altura por linha (medidas uma vez)
+    int *cellx;      // MAT: recuo de cada celula p/ centrar na coluna
+    u8 rows, cols, delim;
+    u8 glyph;        // GLYPH: id do sprite
 };
 
+/* ------------ Glifos proprios (simbolos que a fonte da TI nao tem) ------------
+ * Bitmaps de 1 bit (MSB = coluna da esquerda), convertidos uma vez em sprites
+ * GraphX. A ordem dos ids deve bater com glyph_cp[] em tools/tex2ce.c.
+ */
+#define GLYPH_N  8
+#define GLYPH_H  12
+
+static const u8 g_glyph_w[GLYPH_N] = { 6, 7, 7, 8, 6, 6, 6, 6 };
+static const u8 g_glyph_bits[GLYPH_N][GLYPH_H] = {
+    { 0x18,0x24,0x20,0x20,0x20,0x20,0x20,0x20,0x20,0xA0,0x40,0x00 }, // ∫
+    { 0xFE,0x40,0x20,0x10,0x08,0x10,0x20,0x40,0xFE,0x00,0x00,0x00 }, // ∑
+    { 0x02,0x02,0x04,0x04,0x08,0x88,0x50,0x50,0x20,0x00,0x00,0x00 }, // √
+    { 0x00,0x00,0x00,0x66,0x99,0x99,0x66,0x00,0x00,0x00,0x00,0x00 }, // ∞
+    { 0x70,0x88,0x08,0x08,0x78,0x88,0x88,0x90,0x60,0x00,0x00,0x00 }, // ∂
+    { 0x00,0x00,0x0C,0x30,0xC0,0x30,0x0C,0x00,0xFC,0x00,0x00,0x00 }, // ≤
+    { 0x00,0x00,0xC0,0x30,0x0C,0x30,0xC0,0x00,0xFC,0x00,0x00,0x00 }, // ≥
+    { 0x00,0x00,0x08,0xFC,0x10,0x20,0xFC,0x40,0x00,0x00,0x00,0x00 }, // ≠
+};
+static gfx_sprite_t *g_glyph_spr[GLYPH_N];
+
+static void init_glyphs(void){
+    for (u8 g = 0; g < GLYPH_N; ++g) {
+        u8 w = g_glyph_w[g];
+        gfx_sprite_t *spr = gfx_MallocSprite(w, GLYPH_H);
+        if (!spr) continue;
+        for (u8 r = 0; r < GLYPH_H; ++r)
+            for (u8 c = 0; c < w; ++c)
+                spr->data[r * w + c] = (g_glyph_bits[g][r] & (0x80 >> c)) ? 0 : 255;
+        g_glyph_spr[g] = spr;
+    }
+}
+
 /* ------------ Parser: Stream -> Node (com next) --------------- */
 
+static Node* parse_seq(Stream *s, size_t lim);
+
+// filho com prefixo de tamanho: u16 len + sequencia
+static Node* parse_child(Stream *s){
+    u16 L = rd16(s);
+    Stream s1 = *s; s1.n = s1.i + L;
+    Node *c = parse_seq(&s1, L);
+    s->i += L;
+    return c;
+}
+
 static Node* parse_seq(Stream *s, size_t lim){
     Node *head = NULL, **cur = &head;
     size_t start = s->i;
@@ -89,12 +149,33 @@ static Node* parse_seq(Stream *s, size_t lim){
             n->den = parse_seq(&s2, L2);
             s->i += L2;
 
+        } else if (tag == TAG_SQRT) {
+            n->child = parse_child(s);   // radicando
+            n->num   = parse_child(s);   // indice (\sqrt[n]); vazio = NULL
+
         } else if (tag == TAG_SUP || tag == TAG_SUB) {
             u16 L = rd16(s);
             Stream s1 = *s; s1.n = s1.i + L;
             n->child = parse_seq(&s1, L);
             s->i += L;
 
+        } else if (tag == TAG_BIGOP) {
+            n->child = parse_child(s);   // operador
+            n->den   = parse_child(s);   // limite de baixo
+            n->num   = parse_child(s);   // limite de cima
+
+        } else if (tag == TAG_MAT) {
+            n->rows  = rd8(s);
+            n->cols  = rd8(s);
+            n->delim = rd8(s);
+            u16 nc = (u16)(n->rows * n->cols);
+            n->cell = (Node**)calloc(nc ? nc : 1, sizeof(Node*));
+            for (u16 k = 0; k < nc; ++k) n->cell[k] = parse_child(s);
+
+        } else if (tag == TAG_GLYPH) {
+            n->glyph = rd8(s);
+            if (n->glyph >= GLYPH_N) { free(n); continue; }
+
         } else if (tag == TAG_NL || tag == TAG_PAR) {
             // nada extra
 
@@ -124,6 +205,42 @@ static inline int text_w(const char *s){
 // mede uma sequência inline (somatório de larguras; altura = máx)
 static void measure_seq(Node *seq);
 
+// mede a sequencia e devolve a caixa dela (w = soma, h = max)
+static void seq_box(Node *seq, int *w, int *h){
+    *w = 0; *h = 0;
+    measure_seq(seq);
+    for (Node *p = seq; p; p = p->next) { *w += p->w; if (p->h > *h) *h = p->h; }
+}
+
+// recuo do radical p/ caber o indice: metade do RAD_W fica sob o indice
+static int rad_lead(int iw){ return iw > RAD_W / 2 ? iw - RAD_W / 2 : 0; }
+
+// Matriz com as celulas ja medidas: larguras por coluna e alturas por linha
+// ficam guardadas no no (nada e re-medido ao desenhar).
+static void mat_box(Node *n){
+    if (!n->colw) n->colw = (int*)malloc((n->cols ? n->cols : 1) * sizeof(int));
+    if (!n->rowh) n->rowh = (int*)malloc((n->rows ? n->rows : 1) * sizeof(int));
+    memset(n->colw, 0, (n->cols ? n->cols : 1) * sizeof(int));
+    memset(n->rowh, 0, (n->rows ? n->rows : 1) * sizeof(int));
+    u16 nc = (u16)(n->rows * n->cols);
+    if (!n->cellx) n->cellx = (int*)malloc((nc ? nc : 1) * sizeof(int));
+    for (u8 r = 0; r < n->rows; ++r) {
+        for (u8 c = 0; c < n->cols; ++c) {
+            int cw = 0, ch = 0;
+            for (Node *p = n->cell[r * n->cols + c]; p; p = p->next) { cw += p->w; if (p->h > ch) ch = p->h; }
+            n->cellx[r * n->cols + c] = cw;
+            if (cw > n->colw[c]) n->colw[c] = cw;
+            if (ch > n->rowh[r]) n->rowh[r] = ch;
+        }
+    }
+    for (u16 k = 0; k < nc; ++k) n->cellx[k] = (n->colw[k % n->cols] - n->cellx[k]) / 2;
+    int w = n->delim ? 2 * MAT_DELIM : 0, h = 0;
+    for (u8 c = 0; c < n->cols; ++c) w += n->colw[c] + (c ? MAT_CGAP : 0);
+    for (u8 r = 0; r < n->rows; ++r) h += n->rowh[r] + (r ? MAT_RGAP : 0);
+    n->w = w;
+    n->h = h ? h : text_h();
+}
+
 static void measure_node(Node *n){
     if (!n) return;
 
@@ -174,6 +291,45 @@ static void measure_node(Node *n){
         return;
     }
 
+    if (n->tag == TAG_GLYPH) {
+        n->w = g_glyph_w[n->glyph] + 1;  // 1px de espaco depois do simbolo
+        n->h = text_h();
+        return;
+    }
+
+    if (n->tag == TAG_SQRT) {
+        // o indice fica no alto, a esquerda, entrando no vao do radical
+        int cw, ch, iw, ih;
+        seq_box(n->child, &cw, &ch);
+        seq_box(n->num, &iw, &ih);
+        if (ch < text_h()) ch = text_h();
+        n->w = rad_lead(iw) + RAD_W + 1 + cw + 1;
+        n->h = RAD_TOP + ch;
+        if (ih > n->h) n->h = ih;
+        return;
+    }
+
+    if (n->tag == TAG_BIGOP) {
+        // limites em linha: operador na linha do texto, depois o de baixo
+        // como sub e o de cima como sup, lado a lado (no mesmo x as linhas
+        // de sub e sup se sobrepoem; empilhar exige linha de base).
+        int ow, oh, uw, uh, lw, lh;
+        seq_box(n->child, &ow, &oh);
+        seq_box(n->num, &uw, &uh);
+        seq_box(n->den, &lw, &lh);
+        n->w = ow + lw + uw + 1;
+        n->h = text_h() + (n->den ? SUB_SHIFT : 0);
+        if (oh > n->h) n->h = oh;
+        return;
+    }
+
+    if (n->tag == TAG_MAT) {
+        u16 nc = (u16)(n->rows * n->cols);
+        for (u16 k = 0; k < nc; ++k) measure_seq(n->cell[k]);
+        mat_box(n);
+        return;
+    }
+
     if (n->tag == TAG_NL || n->tag == TAG_PAR) {
         n->w = 0; n->h = text_h();
         return;
@@ -195,52 +351,31 @@ static void draw_one(Node *p, int x, int y);
 // Flag de contexto: estamos dentro de uma fracao?
 static int g_in_frac = 0;
 
-// Largura util (margens iguais as do main)
+// Largura util (margens iguais as do main). Tambem e a janela de recorte
+// horizontal: nada e desenhado fora de [g_left, g_right).
 static int g_left  = 8;
 static int g_right = 312;
 
-// Quebra e desenha um texto longo respeitando a largura disponivel da linha.
-// Atualiza x,y,lineH conforme quebra linhas.
-static void draw_text_wrap(const char *s, int *x, int *y, int *lineH){
-    while (*s) {
-        int avail = g_right - *x;
-        if (avail <= 0) {
-            // nova linha
-            *x = g_left;
-            *y += *lineH + LEADING;
-            *lineH = text_h();
-            avail = g_right - *x;
-        }
-        int fullw = gfx_GetStringWidth(s);
-        if (fullw <= avail) {
-            // cabe inteiro
-            gfx_PrintStringXY(s, *x, *y);
-            *x += fullw;
-            return;
-        }
-        // procura o ultimo espaco que caiba
-        int i = 0, last_space = -1, wacc = 0;
-        while (s[i]) {
-            int cw = gfx_GetCharWidth(s[i]);
-            if (wacc + cw > avail) break;
-            if (s[i] == ' ') last_space = i;
-            wacc += cw; i++;
-        }
-        int cut = (last_space >= 0) ? last_space : i; // hard-break se nao houver espaco
-        if (cut <= 0) cut = 1; // garante progresso
-        // desenha o trecho [0..cut)
-        char *chunk = (char*)malloc((size_t)cut + 1);
-        memcpy(chunk, s, (size_t)cut);
-        chunk[cut] = 0;
-        gfx_PrintStringXY(chunk, *x, *y);
-        free(chunk);
-        // quebra de linha logo apos o trecho
-        *x = g_left;
-        *y += *lineH + LEADING;
-        *lineH = text_h();
-        // avanca o ponteiro do texto (pula um espaco se for o caso)
-        s += cut;
-        if (*s == ' ') s++;
+// Desenha s[0..len) (largura w) em x,y so com os glifos inteiros que cabem
+// entre g_left e g_right. Glifos cortados na borda ficam de fora.
+static void draw_text_clip(const char *s, u16 len, int w, int x, int y){
+    if (x >= g_left && x + w <= g_right) {      // caso comum: tudo visivel
+        fontlib_SetCursorPosition(x, y);
+        fontlib_DrawStringL(s, len);
+        return;
+    }
+    u16 i = 0;
+    while (i < len && s[i] && x < g_left) { x += fontlib_GetGlyphWidth(s[i]); i++; }
+    u16 j = i;
+    int xr = x;
+    while (j < len && s[j]) {
+        int cw = fontlib_GetGlyphWidth(s[j]);
+        if (xr + cw > g_right) break;
+        xr += cw; j++;
+    }
+    if (j > i) {
+        fontlib_SetCursorPosition(x, y);
+        fontlib_DrawStringL(s + i, j - i);
     }
 }
 
@@ -250,8 +385,7 @@ static void draw_one(Node *p, int x, int y){
     if (!p) return;
 
     if (p->tag == TAG_TEXT) {
-        fontlib_SetCursorPosition(x, y);
-        fontlib_DrawString(p->text);
+        draw_text_clip(p->text, 0xFFFF, p->w, x, y);
         return;
     }
 
@@ -299,21 +433,281 @@ static void draw_one(Node *p, int x, int y){
         return;
     }
 
+    if (p->tag == TAG_GLYPH) {
+        if (g_glyph_spr[p->glyph]) gfx_TransparentSprite(g_glyph_spr[p->glyph], x, y + 1);
+        return;
+    }
+
+    if (p->tag == TAG_SQRT) {
+        // radical: tique, descida ate o pe, subida ate o traco de cima;
+        // com indice o tique comeca abaixo dele
+        int iw = 0, ty = y + p->h / 2;
+        if (p->num) {
+            for (Node *q=p->num; q; q=q->next) iw += q->w;
+            draw_seq(p->num, x, y);
+            if (ty < y + text_h() - 2) ty = y + text_h() - 2;
+            x += rad_lead(iw);
+        }
+        int yb = y + p->h - 1;
+        gfx_SetColor(0);
+        gfx_Line(x, ty, x + 2, yb);
+        gfx_Line(x + 2, yb, x + RAD_W - 1, y + 1);
+        gfx_Line(x + RAD_W - 1, y + 1, x + p->w - 1 - rad_lead(iw), y + 1);
+        if (p->child) draw_seq(p->child, x + RAD_W + 1, y + RAD_TOP);
+        return;
+    }
+
+    if (p->tag == TAG_BIGOP) {
+        int ow=0, lw=0;
+        for (Node *q=p->child; q; q=q->next) ow+=q->w;
+        for (Node *q=p->den;   q; q=q->next) lw+=q->w;
+        if (p->child) draw_seq(p->child, x, y);
+        if (p->den)   draw_seq(p->den, x + ow, y + SUB_SHIFT);
+        if (p->num)   draw_seq(p->num, x + ow + lw, y + (g_in_frac ? SUP_DOWN : SUP_SHIFT));
+        return;
+    }
+
+    if (p->tag == TAG_MAT) {
+        int x0 = x + (p->delim ? MAT_DELIM : 0);
+        int xr = x + p->w - 1, yb = y + p->h - 1;
+
+        gfx_SetColor(0);
+        if (p->delim == '(') {
+            gfx_Line(x + 3, y, x + 1, y + 2);   gfx_Line(x + 1, y + 2, x + 1, yb - 2);   gfx_Line(x + 1, yb - 2, x + 3, yb);
+            gfx_Line(xr - 3, y, xr - 1, y + 2); gfx_Line(xr - 1, y + 2, xr - 1, yb - 2); gfx_Line(xr - 1, yb - 2, xr - 3, yb);
+        } else if (p->delim == '[') {
+            gfx_Line(x + 1, y, x + 1, yb);   gfx_Line(x + 1, y, x + 3, y);   gfx_Line(x + 1, yb, x + 3, yb);
+            gfx_Line(xr - 1, y, xr - 1, yb); gfx_Line(xr - 3, y, xr - 1, y); gfx_Line(xr - 3, yb, xr - 1, yb);
+        } else if (p->delim == '|') {
+            gfx_Line(x + 1, y, x + 1, yb);
+            gfx_Line(xr - 1, y, xr - 1, yb);
+        }
+
+        // celulas centradas na coluna; usa colw/rowh/cellx ja medidos e
+        // pula linhas inteiras acima ou abaixo da tela
+        int cy = y;
+        for (u8 r = 0; r < p->rows && cy < 240; ++r) {
+            if (cy + p->rowh[r] <= 0) { cy += p->rowh[r] + MAT_RGAP; continue; }
+            int cx = x0;
+            for (u8 c = 0; c < p->cols; ++c) {
+                if (cx >= g_right) break;
+                u16 k = (u16)(r * p->cols + c);
+                if (p->cell[k] && cx + p->colw[c] > g_left)
+                    draw_seq(p->cell[k], cx + p->cellx[k], cy);
+                cx += p->colw[c] + MAT_CGAP;
+            }
+            cy += p->rowh[r] + MAT_RGAP;
+        }
+        return;
+    }
+
     // NL/PAR não desenham nada
 }
 
 static void draw_seq(Node *seq, int x, int y){
     for (Node *p = seq; p; p = p->next) {
-        // Para se já passamos do fim da tela
-        if (y > 240) break;
+        // Para se já passamos do fim da tela (embaixo ou a direita)
+        if (y > 240 || x >= g_right) break;
 
-        draw_one(p, x, y);
+        // so desenha o que cruza as colunas visiveis
+        if (x + p->w > g_left) draw_one(p, x, y);
         x += p->w;
     }
 }
 
+/* ---------------- Layout (quebra de linhas) ----------------
+ * Calculado uma unica vez por documento. A sequencia de topo vira uma lista
+ * de fragmentos (Frag) agrupados em linhas (Line); um TEXT longo pode ser
+ * partido em varios fragmentos. Por frame so percorremos as linhas visiveis.
+ */
+
+typedef struct {
+    u16 node;       // no de origem: indice em g_top
+    u16 off, len;   // TEXT: trecho [off, off+len) do texto
+    int x, w;       // posicao relativa a g_left e largura
+} Frag;
+
+typedef struct {
+    u16 first, count;   // fragmentos [first, first+count)
+    int y, h, w;        // topo (coord. do documento), altura e largura usada
+} Line;
+
+// nos do nivel de topo em ordem; Frag guarda indice (e nao ponteiro) para
+// que linhas e fragmentos possam ir para o cache sem conversao
+static Node **g_top = NULL;
+static u16 g_ntop = 0;
+
+static Frag *g_frags = NULL;
+static Line *g_lines = NULL;
+static u16 g_nfrags = 0, g_capfrags = 0;
+static u16 g_nlines = 0, g_caplines = 0;
+static int g_doc_h = 0;     // altura total do documento
+static int g_doc_w = 0;     // largura da linha mais larga
+
+// cursor do layout
+static int g_lx = 0, g_ly = 0;
+static u16 g_li = 0;
+
+static u16 line_open(int y){
+    if (g_nlines == g_caplines) {
+        g_caplines = g_caplines ? g_caplines * 2 : 32;
+        g_lines = (Line*)realloc(g_lines, g_caplines * sizeof(Line));
+    }
+    Line *L = &g_lines[g_nlines];
+    L->first = g_nfrags; L->count = 0;
+    L->y = y; L->h = text_h(); L->w = 0;
+    return g_nlines++;
+}
+
+static void lay_newline(int extra){
+    g_ly += g_lines[g_li].h + LEADING + extra;
+    g_li = line_open(g_ly);
+    g_lx = 0;
+}
+
+static void index_top(Node *doc){
+    g_ntop = 0;
+    for (Node *p = doc; p; p = p->next) g_ntop++;
+    g_top = (Node**)malloc((g_ntop ? g_ntop : 1) * sizeof(Node*));
+    u16 i = 0;
+    for (Node *p = doc; p; p = p->next) g_top[i++] = p;
+}
+
+static void lay_put(u16 node, u16 off, u16 len, int w){
+    Node *n = g_top[node];
+    if (g_nfrags == g_capfrags) {
+        g_capfrags = g_capfrags ? g_capfrags * 2 : 64;
+        g_frags = (Frag*)realloc(g_frags, g_capfrags * sizeof(Frag));
+    }
+    Frag *f = &g_frags[g_nfrags++];
+    Line *L = &g_lines[g_li];
+    f->node = node; f->off = off; f->len = len;
+    f->x = g_lx; f->w = w;
+    L->count++;
+    g_lx += w;
+    if (g_lx > L->w) L->w = g_lx;
+    if (n->h > L->h) L->h = n->h;
+}
+
+static inline int is_op(char c){
+    return c == '+' || c == '-' || c == '=' || c == '<' || c == '>' || c == ',' || c == ';';
+}
+
+static inline int is_digit(char c){ return c >= '0' && c <= '9'; }
+
+// Pode quebrar logo depois de s[i]? Depois de espaco, ou depois de um
+// operador que nao emenda em outro (nao separa "->", "<=", "+/-").
+// "-" so quebra como menos binario ("a-b"): nao no sinal de "x = -3" nem
+// no expoente de "3.0e-6"; "," nao quebra a virgula decimal de "1,5".
+static inline int can_break_after(const char *s, u16 i){
+    if (s[i] == ' ') return 1;
+    if (!is_op(s[i]) || s[i+1] == ' ' || is_op(s[i+1]) || s[i+1] == '/') return 0;
+    char a = i ? s[i-1] : ' ';
+    if (s[i] == '-') {
+        if (a == ' ' || is_op(a)) return 0;
+        if ((a == 'e' || a == 'E') && i > 1 && (is_digit(s[i-2]) || s[i-2] == '.')) return 0;
+    }
+    if (s[i] == ',' && is_digit(a) && is_digit(s[i+1])) return 0;
+    return 1;
+}
+
+// Quebra um TEXT em fragmentos que cabem na linha (first-fit).
+static void lay_text(u16 node, int W){
+    const char *s = g_top[node]->text;
+    u16 len = (u16)strlen(s), off = 0;
+    int wrapped = 0;
+
+    while (off < len) {
+        // espacos no inicio de uma linha quebrada por nos sao descartados
+        if (wrapped) {
+            while (off < len && s[off] == ' ') off++;
+            if (off >= len) break;
+        }
+        int avail = W - g_lx;
+        int wacc = 0, wbrk = 0;
+        u16 fit = 0, brk = 0;
+
+        // maior prefixo que cabe e o ultimo ponto de quebra dentro dele
+        while (off + fit < len) {
+            int cw = fontlib_GetGlyphWidth(s[off + fit]);
+            if (wacc + cw > avail) break;
+            wacc += cw;
+            if (can_break_after(s, off + fit)) { brk = fit + 1; wbrk = wacc; }
+            fit++;
+        }
+
+        if (off + fit == len) {             // o resto cabe inteiro
+            lay_put(node, off, fit, wacc);
+            return;
+        }
+        if (brk > 0) {
+            lay_put(node, off, brk, wbrk);
+            off += brk;
+        } else if (g_lx == 0) {
+            // palavra maior que a linha inteira: corte forcado
+            if (fit == 0) { fit = 1; wacc = fontlib_GetGlyphWidth(s[off]); }
+            lay_put(node, off, fit, wacc);
+            off += fit;
+        }
+        // senao nada cabe no que sobrou da linha: so quebra
+        lay_newline(0);
+        wrapped = 1;
+    }
+}
+
+static void layout_doc(void){
+    const int W = g_right - g_left;
+
+    g_nfrags = 0; g_nlines = 0;
+    g_lx = 0; g_ly = 0;
+    g_li = line_open(0);
+
+    for (u16 i = 0; i < g_ntop; ++i) {
+        Node *p = g_top[i];
+        if (p->tag == TAG_NL || p->tag == TAG_PAR) {
+            lay_newline(p->tag == TAG_PAR ? text_h() : 0);
+            continue;
+        }
+        if (p->tag == TAG_TEXT) {
+            lay_text(i, W);
+            continue;
+        }
+        // caixas inteiras; sup/sub ficam colados na base (nunca abrem linha)
+        int glue = (p->tag == TAG_SUP || p->tag == TAG_SUB);
+        if (!glue && g_lx > 0 && g_lx + p->w > W) lay_newline(0);
+        lay_put(i, 0, 0, p->w);
+    }
+
+    g_doc_h = g_ly + g_lines[g_li].h;
+    g_doc_w = 0;
+    for (u16 k = 0; k < g_nlines; ++k)
+        if (g_lines[k].w > g_doc_w) g_doc_w = g_lines[k].w;
+}
+
+// primeira linha com topo >= y (linhas estao em ordem crescente de y)
+static u16 line_at(int y){
+    u16 lo = 0, hi = g_nlines;
+    while (lo < hi) {
+        u16 mid = (u16)((lo + hi) / 2);
+        if (g_lines[mid].y < y) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+static void draw_frag(const Frag *f, int x, int y){
+    Node *n = g_top[f->node];
+    if (n->tag == TAG_TEXT) {
+        draw_text_clip(n->text + f->off, f->len, f->w, x, y);
+    } else {
+        draw_one(n, x, y);
+    }
+}
+
 /* ---------------- Carregamento do AppVar ---------------- */
 
+static uint32_t g_doc_sum = 0;   // checksum do AppVar (chave do cache)
+static uint32_t checksum(const u8 *p, size_t n);
+
 static Node* load_doc(void){
     ti_var_t v = ti_Open(DOC_NAME_STR,"r");
     if (!v) return NULL;
@@ -326,6 +720,7 @@ static Node* load_doc(void){
 
     ti_Read(buf, sz, 1, v);
     ti_Close(v);
+    g_doc_sum = checksum(buf, sz);
 
     Stream s = { .p = buf, .n = sz, .i = 0 };
     Node *doc = parse_seq(&s, 0);
@@ -333,6 +728,181 @@ static Node* load_doc(void){
     return doc;
 }
 
+/* ---------------- Cache de layout (AppVar companheiro) ----------------
+ * Guarda scroll/pan, as medidas de todos os nos e as linhas/fragmentos num
+ * AppVar "<DOC>c" (ate 7 letras do nome do documento + 'c'). So vale se o
+ * checksum do documento, a fonte e o formato baterem; senao o layout e
+ * refeito do zero e o cache e regravado na saida.
+ */
+#define CACHE_MAGIC   0x564C   // "LV"
+#define CACHE_VERSION 3
+
+typedef struct {
+    u16 magic;
+    u8  version;
+    uint32_t doc_sum;   // checksum do AppVar do documento
+    u16 font_key;       // larguras da fonte + largura util
+    int scroll, pan;
+    int doc_h, doc_w;
+    u16 nnodes, nlines, nfrags;
+} CacheHdr;
+
+static int g_cache_ok = 0;   // cache lido e valido: na saida so o cabecalho muda
+
+// Fletcher-32 simplificado (somas de 16 bits)
+static uint32_t checksum(const u8 *p, size_t n){
+    u16 a = 1, b = 0;
+    for (size_t i = 0; i < n; ++i) { a += p[i]; b += a; }
+    return ((uint32_t)b << 16) | a;
+}
+
+static u16 font_key(void){
+    u16 a = (u16)(text_h() + (g_right - g_left)), b = 0;
+    for (int c = 1; c < 256; ++c) { a += fontlib_GetGlyphWidth((char)c); b += a; }
+    return (u16)((b << 8) ^ a);
+}
+
+static void cache_name(char *name){
+    size_t k = strlen(DOC_NAME_STR);
+    if (k > 7) k = 7;
+    memcpy(name, DOC_NAME_STR, k);
+    name[k] = 'c'; name[k + 1] = 0;
+}
+
+static u16 count_nodes(Node *seq){
+    u16 n = 0;
+    for (Node *p = seq; p; p = p->next) {
+        n += 1 + count_nodes(p->num) + count_nodes(p->den) + count_nodes(p->child);
+        for (u16 k = 0; k < p->rows * p->cols; ++k) n += count_nodes(p->cell[k]);
+    }
+    return n;
+}
+
+// Percorre a arvore (filhos antes do pai). save: copia w/h para *cur;
+// senao le de *cur, e as matrizes recalculam colw/rowh das celulas.
+static void metrics_walk(Node *seq, int16_t **cur, int save){
+    for (Node *p = seq; p; p = p->next) {
+        metrics_walk(p->num, cur, save);
+        metrics_walk(p->den, cur, save);
+        metrics_walk(p->child, cur, save);
+        for (u16 k = 0; k < p->rows * p->cols; ++k) metrics_walk(p->cell[k], cur, save);
+        if (save) {
+            *(*cur)++ = (int16_t)p->w;
+            *(*cur)++ = (int16_t)p->h;
+        } else {
+            p->w = *(*cur)++;
+            p->h = *(*cur)++;
+            if (p->tag == TAG_MAT) mat_box(p);
+        }
+    }
+}
+
+// Linhas e fragmentos vem de uma AppVar que o checksum do documento nao
+// cobre: confere os indices antes de usar (cache estragado = refaz layout).
+static int cache_check(u16 nlines, u16 nfrags){
+    for (u16 i = 0; i < nlines; ++i)
+        if ((unsigned long)g_lines[i].first + g_lines[i].count > nfrags) return 0;
+    u16 last = 0xFFFF;
+    size_t tl = 0;
+    for (u16 k = 0; k < nfrags; ++k) {
+        const Frag *f = &g_frags[k];
+        if (f->node >= g_ntop) return 0;
+        Node *n = g_top[f->node];
+        if (n->tag != TAG_TEXT) continue;
+        if (f->node != last) { last = f->node; tl = strlen(n->text); }
+        if ((size_t)f->off + f->len > tl) return 0;
+    }
+    return 1;
+}
+
+// Restaura medidas, linhas, fragmentos e posicao. 0 = sem cache valido.
+static int cache_load(Node *doc, int *scroll, int *pan){
+    char name[9];
+    cache_name(name);
+    ti_var_t v = ti_Open(name, "r");
+    if (!v) return 0;
+
+    CacheHdr h;
+    int ok = ti_Read(&h, sizeof h, 1, v) == 1
+          && h.magic == CACHE_MAGIC && h.version == CACHE_VERSION
+          && h.doc_sum == g_doc_sum && h.font_key == font_key()
+          && h.nnodes == count_nodes(doc) && h.nlines > 0;
+
+    int16_t *m = NULL;
+    if (ok) {
+        m = (int16_t*)malloc(h.nnodes * 2 * sizeof(int16_t));
+        // realloc em temporarios: se faltar heap, g_lines/g_frags e as
+        // capacidades continuam validos p/ o layout_doc() de fallback
+        u16 cf = h.nfrags ? h.nfrags : 1;
+        Line *nl = (Line*)realloc(g_lines, h.nlines * sizeof(Line));
+        if (nl) { g_lines = nl; g_caplines = h.nlines; }
+        Frag *nf = (Frag*)realloc(g_frags, cf * sizeof(Frag));
+        if (nf) { g_frags = nf; g_capfrags = cf; }
+        ok = m && nl && nf
+          && ti_Read(m, 2 * sizeof(int16_t), h.nnodes, v) == h.nnodes
+          && ti_Read(g_lines, sizeof(Line), h.nlines, v) == h.nlines
+          && ti_Read(g_frags, sizeof(Frag), h.nfrags, v) == h.nfrags
+          && cache_check(h.nlines, h.nfrags);
+    }
+    ti_Close(v);
+
+    if (ok) {
+        int16_t *cur = m;
+        metrics_walk(doc, &cur, 0);
+        g_nlines = h.nlines; g_nfrags = h.nfrags;
+        g_doc_h = h.doc_h;   g_doc_w = h.doc_w;
+        *scroll = h.scroll;  *pan = h.pan;
+    }
+    free(m);
+    g_cache_ok = ok;
+    return ok;
+}
+
+static void cache_save(Node *doc, int scroll, int pan){
+    char name[9];
+    cache_name(name);
+    CacheHdr h = {
+        .magic = CACHE_MAGIC, .version = CACHE_VERSION,
+        .doc_sum = g_doc_sum, .font_key = font_key(),
+        .scroll = scroll, .pan = pan,
+        .doc_h = g_doc_h, .doc_w = g_doc_w,
+        .nnodes = count_nodes(doc), .nlines = g_nlines, .nfrags = g_nfrags,
+    };
+    ti_var_t v;
+
+    // layout veio do cache: so a posicao mudou
+    if (g_cache_ok && (v = ti_Open(name, "r+"))) {
+        ti_Write(&h, sizeof h, 1, v);
+        ti_Close(v);
+        return;
+    }
+
+    int16_t *m = (int16_t*)malloc(h.nnodes * 2 * sizeof(int16_t));
+    if (!m) return;
+    int16_t *cur = m;
+    metrics_walk(doc, &cur, 1);
+
+    v = ti_Open(name, "w");
+    if (v) {
+        ti_Write(&h, sizeof h, 1, v);
+        ti_Write(m, 2 * sizeof(int16_t), h.nnodes, v);
+        ti_Write(g_lines, sizeof(Line), g_nlines, v);
+        ti_Write(g_frags, sizeof(Frag), g_nfrags, v);
+        ti_Close(v);
+    }
+    free(m);
+}
+
+// Overlay de depuracao ([mode] liga/desliga): frames desenhados por segundo
+// de relogio, com uma casa decimal. Parado numa pagina deve ficar perto de 0.
+static void draw_overlay(unsigned fps10){
+    gfx_SetTextXY(232, 8);
+    gfx_PrintString("fps ");
+    gfx_PrintUInt(fps10 / 10, 1);
+    gfx_PrintChar('.');
+    gfx_PrintUInt(fps10 % 10, 1);
+}
+
 static int init_os_font(void){
     // Pega a primeira fonte dentro do appvar OSLFONT
     g_font = fontlib_GetFontByIndex("OSLFONT", 0);
@@ -368,6 +938,7 @@ int main(void){
     gfx_SetTextFGColor(0);
     gfx_SetTextBGColor(255);
     gfx_SetTextTransparentColor(255);
+    gfx_SetTransparentColor(255);     // fundo dos sprites de glifo
 
     kb_EnableOnLatch();
 
@@ -394,110 +965,126 @@ int main(void){
         return 0;
     }
 
-    // mede as larguras/alturas usando FontLib (text_w / text_h)
-    measure_seq(doc);
+    init_glyphs();
 
-    uint8_t prev7 = 0;
-    int warmup = 2;
-    int scroll = 0;
     const int left  = 8;
     const int right = 312;   // 320 - 8 de margem de cada lado
+    const int top   = 24;    // "respiro" no topo
+
+    g_left = left; g_right = right;
+    index_top(doc);
+
+    int scroll = 0;
+    int pan = 0;             // deslocamento horizontal (linhas largas)
+
+    // Reabre onde parou: medidas, linhas e posicao vem do cache se o
+    // documento e a fonte nao mudaram. Senao mede (FontLib) e quebra as
+    // linhas uma vez so; o loop abaixo so le g_lines/g_frags.
+    if (!cache_load(doc, &scroll, &pan)) {
+        measure_seq(doc);
+        layout_doc();
+    }
+
+    // recorte horizontal p/ as linhas da GraphX (barras de fracao etc.)
+    gfx_SetClipRegion(left, 0, right, 240);
+
+    uint8_t prev7 = 0, prev1 = 0;
+    int warmup = 2;
+    int pan_max = g_doc_w - (right - left);
+    if (pan_max < 0) pan_max = 0;
+    // para quando a ultima linha encosta no fim da tela
+    int scroll_max = g_doc_h - (240 - top);
+    if (scroll_max < 0) scroll_max = 0;
+
+    // So redesenha quando algo muda; parado, o loop so olha o teclado a
+    // cada IDLE_MS em vez de redesenhar a tela inteira sem parar. delay()
+    // e espera ocupada, entao a economia de bateria vem de baixar o clock
+    // p/ 6 MHz enquanto ocioso (volta a 48 MHz antes de desenhar).
+    int dirty = 1;
+    int slow = 0;            // CPU a 6 MHz
+    int tick = 0;            // redesenho so p/ atualizar o overlay
+    int overlay = 0;
+    unsigned frames = 0, fps10 = 0;
+    clock_t t0 = clock();
 
     while (1) {
         kb_Scan();
         if (kb_On) {
+            if (slow) boot_Set48MHzMode();
+            cache_save(doc, scroll, pan);
             kb_ClearOnLatch();
             kb_DisableOnLatch();
             gfx_End();
             return 0;
         }
         uint8_t cur7 = kb_Data[7];
+        uint8_t cur1 = kb_Data[1];
+        int old_scroll = scroll, old_pan = pan;
 
         if (warmup > 0) {
             warmup--;
         } else {
             uint8_t justDown = (cur7 & kb_Down) & ~(prev7 & kb_Down);
             uint8_t justUp   = (cur7 & kb_Up)   & ~(prev7 & kb_Up);
+            uint8_t justLeft = (cur7 & kb_Left) & ~(prev7 & kb_Left);
+            uint8_t justRight= (cur7 & kb_Right)& ~(prev7 & kb_Right);
 
             if (justDown) scroll += 8;
             if (justUp)   scroll -= 8;
+            if (justRight) pan += PAN_STEP;
+            if (justLeft)  pan -= PAN_STEP;
+
+            if ((cur1 & kb_Mode) & ~(prev1 & kb_Mode)) { overlay = !overlay; dirty = 1; }
         }
         prev7 = cur7;
+        prev1 = cur1;
+        if (scroll > scroll_max) scroll = scroll_max;
         if (scroll < 0) scroll = 0;
+        if (pan > pan_max) pan = pan_max;
+        if (pan < 0) pan = 0;
+        if (scroll != old_scroll || pan != old_pan) dirty = 1;
+
+        // janela de 1s de relogio p/ o overlay (que se redesenha ao virar)
+        clock_t now = clock();
+        if (now - t0 >= CLOCKS_PER_SEC) {
+            fps10 = (unsigned)((unsigned long)frames * 10 * CLOCKS_PER_SEC / (unsigned long)(now - t0));
+            frames = 0;
+            t0 = now;
+            if (overlay && !dirty) { dirty = 1; tick = 1; }
+        }
+
+        if (!dirty) {
+            if (!slow) { boot_Set6MHzMode(); slow = 1; }
+            delay(IDLE_MS);
+            continue;
+        }
+        dirty = 0;
+        if (slow) { boot_Set48MHzMode(); slow = 0; }
 
         gfx_FillScreen(255);
         gfx_SetColor(0);          // garante preto p/ a barra da fracao
 
-        g_left = left; g_right = right;
-        int x = left, y = 24 - scroll;   // “respiro” no topo
-        int lineH = text_h();            // altura atual da linha (dinâmica)
-
-        Node *p = doc;
-        while (p) {
-            if (p->tag == TAG_NL || p->tag == TAG_PAR) {
-                x = left;
-                y += lineH + LEADING + (p->tag == TAG_PAR ? text_h() : 0);
-                lineH = text_h();
-                p = p->next;
-                continue;
-            }
-
-            // --- NOVO: se a linha atual esta inteira acima do topo, pula ela ---
-            if (y < 0) {
-                // Consome-nos ate o fim da linha (NL/PAR) sem desenhar
-                while (p && p->tag != TAG_NL && p->tag != TAG_PAR) {
-                    // ainda atualiza o lineH para subir corretamente
-                    if (p->h > lineH) lineH = p->h;
-                    p = p->next;
-                }
-                // aplica a quebra de linha uma unica vez
-                x = left;
-                y += lineH + LEADING;
-                lineH = text_h();
-                // se chegou num PAR, adiciona a linha extra e avanca esse token
-                if (p && p->tag == TAG_PAR) {
-                    y += text_h();
-                }
-                // avanca o token NL/PAR (se havia) e segue
-                if (p) p = p->next;
-                continue;
+        // Anti-flicker: linhas que comecariam acima do topo nao sao desenhadas
+        for (u16 i = line_at(scroll - top); i < g_nlines; ++i) {
+            const Line *L = &g_lines[i];
+            int y = top - scroll + L->y;
+            if (y >= 240) break;  // abaixo da tela: pare
+
+            // frags estao em x crescente: pula os que ficaram a esquerda
+            // e para no primeiro que passa da direita
+            for (u16 k = 0; k < L->count; ++k) {
+                const Frag *f = &g_frags[L->first + k];
+                int x = left + f->x - pan;
+                if (x >= right) break;
+                if (x + f->w <= left) continue;
+                draw_frag(f, x, y);
             }
-            // -------------------------------------------------------------------
-
-            // quebra de linha automatica para itens nao-TEXT
-            if (p->tag != TAG_TEXT && x + p->w > right) {
-                x = left;
-                y += lineH + LEADING;
-                lineH = text_h();
-            }
-
-            if (y >= 240) break; // abaixo da tela: pare
-
-            // desenha; TAG_TEXT tem wrap interno
-            if (p->tag == TAG_TEXT) {
-                int w = fontlib_GetStringWidth(p->text);
-
-                // Se não couber na linha, quebra ANTES do texto todo
-                if (x + w > right) {
-                    x = left;
-                    y += lineH + LEADING;
-                    lineH = text_h();
-                }
-
-                fontlib_SetCursorPosition(x, y);
-                fontlib_DrawString(p->text);
-                x += w;
-
-                if (text_h() > lineH) lineH = text_h();
-            } else {
-                draw_one(p, x, y);
-                if (p->h > lineH) lineH = p->h;
-                x += p->w;
-            }
-
-            p = p->next;
         }
 
+        if (overlay) draw_overlay(fps10);
+
         gfx_SwapDraw();
+        if (!tick) frames++;      // o refresh do proprio overlay nao conta
+        tick = 0;
     }
 }
@@ -0,0 +1,282 @@
+// ce2dis.c — desmonta o bytecode do tex2ce (out.bin) e mostra onde vão os bytes
+// Uso: ce2dis out.bin [-t]     (-t imprime a árvore inteira)
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t  u8;
+typedef uint16_t u16;
+
+#define TAG_TEXT   0x01
+#define TAG_FRAC   0x02
+#define TAG_SUP    0x03
+#define TAG_SUB    0x04
+#define TAG_NL     0x05
+#define TAG_PAR    0x06
+#define TAG_SQRT   0x07
+#define TAG_MAT    0x08
+#define TAG_BIGOP  0x09
+#define TAG_GLYPH  0x0A
+#define TAG_END    0xFF
+
+static const char *tag_name(u8 t){
+    switch (t) {
+        case TAG_TEXT:  return "TEXT";
+        case TAG_FRAC:  return "FRAC";
+        case TAG_SUP:   return "SUP";
+        case TAG_SUB:   return "SUB";
+        case TAG_NL:    return "NL";
+        case TAG_PAR:   return "PAR";
+        case TAG_SQRT:  return "SQRT";
+        case TAG_MAT:   return "MATRIX";
+        case TAG_BIGOP: return "BIGOP";
+        case TAG_GLYPH: return "GLYPH";
+        case TAG_END:   return "END";
+    }
+    return "?";
+}
+
+static const char *glyph_name[] = { "∫", "∑", "√", "∞", "∂", "≤", "≥", "≠" };
+
+/* ---------------- Estatísticas ---------------- */
+
+typedef struct { unsigned count; size_t head, payload; } TagStat;
+static TagStat g_tag[256];
+
+// histograma do tamanho dos TEXT: 0, 1, 2-3, 4-7, ..., 64+
+#define HIST_N 8
+static unsigned g_hist[HIST_N];
+static int g_maxdepth = 0;
+static unsigned g_nodes = 0;
+static int g_tree = 0;
+static int g_bad = 0;
+
+// textos repetidos: hash aberto por conteúdo
+typedef struct { const u8 *s; u16 len; unsigned count; } Str;
+static Str *g_str = NULL;
+static size_t g_nstr = 0, g_capstr = 0;
+
+static uint32_t fnv(const u8 *s, u16 n){
+    uint32_t h = 2166136261u;
+    for (u16 i = 0; i < n; ++i) { h ^= s[i]; h *= 16777619u; }
+    return h;
+}
+
+static void str_add(const u8 *s, u16 n){
+    if (g_nstr * 2 >= g_capstr) {                  // mantém carga <= 1/2
+        size_t ocap = g_capstr;
+        Str *old = g_str;
+        g_capstr = g_capstr ? g_capstr * 2 : 256;
+        g_str = (Str*)calloc(g_capstr, sizeof(Str));
+        for (size_t i = 0; i < ocap; ++i) {
+            if (!old[i].s) continue;
+            size_t j = fnv(old[i].s, old[i].len) & (g_capstr - 1);
+            while (g_str[j].s) j = (j + 1) & (g_capstr - 1);
+            g_str[j] = old[i];
+        }
+        free(old);
+    }
+    size_t j = fnv(s, n) & (g_capstr - 1);
+    while (g_str[j].s) {
+        if (g_str[j].len == n && memcmp(g_str[j].s, s, n) == 0) { g_str[j].count++; return; }
+        j = (j + 1) & (g_capstr - 1);
+    }
+    g_str[j].s = s; g_str[j].len = n; g_str[j].count = 1;
+    g_nstr++;
+}
+
+// bytes totais gastos por uma string repetida (cabeçalho + texto)
+static size_t str_cost(const Str *a){ return (size_t)a->count * (3u + a->len); }
+
+static int str_cmp(const void *x, const void *y){
+    size_t a = str_cost((const Str*)x), b = str_cost((const Str*)y);
+    return (a < b) - (a > b);
+}
+
+static void print_text(const u8 *s, u16 n, u16 max){
+    putchar('"');
+    for (u16 i = 0; i < n && i < max; ++i) {
+        if (s[i] >= 0x20 && s[i] < 0x7F && s[i] != '"' && s[i] != '\\') putchar(s[i]);
+        else printf("\\x%02X", s[i]);
+    }
+    if (n > max) printf("...");
+    putchar('"');
+}
+
+/* ---------------- Leitura ---------------- */
+
+typedef struct { const u8 *p; size_t n, i, base; } Rd;   // base: offset de p no arquivo
+static int rd8 (Rd *r){ return (r->i < r->n) ? r->p[r->i++] : (g_bad = 1, -1); }
+static u16 rd16(Rd *r){
+    if (r->i + 2 > r->n) { g_bad = 1; r->i = r->n; return 0; }
+    u16 x = (u16)(r->p[r->i] | (r->p[r->i+1] << 8));
+    r->i += 2;
+    return x;
+}
+
+// depth = nível de aninhamento; cada nível ocupa 2 recuos (rótulo + nós)
+static void indent(int n){ for (int d = 0; d < n; ++d) printf("  "); }
+
+static void dis_seq(Rd *r, int depth);
+
+// filho com prefixo de tamanho (u16 len + sequência)
+static void dis_child(Rd *r, int depth, const char *label){
+    u16 L = rd16(r);
+    if (r->i + L > r->n) { g_bad = 1; L = (u16)(r->n - r->i); }
+    if (g_tree) { indent(2 * depth + 1); printf("%s (%u bytes)\n", label, L); }
+    Rd sub = { r->p + r->i, L, 0, r->base + r->i };
+    dis_seq(&sub, depth + 1);
+    r->i += L;
+}
+
+static void dis_seq(Rd *r, int depth){
+    if (depth > g_maxdepth) g_maxdepth = depth;
+
+    while (r->i < r->n) {
+        size_t at = r->i;
+        int t = rd8(r);
+        if (t < 0) return;
+        TagStat *ts = &g_tag[t];
+        ts->count++;
+        if (t != TAG_END) g_nodes++;                 // igual ao contador do tex2ce
+
+        if (g_tree) { indent(2 * depth); printf("%06zX %s", r->base + at, tag_name((u8)t)); }
+
+        if (t == TAG_END) {
+            ts->head += 1;
+            if (g_tree) putchar('\n');
+            return;
+
+        } else if (t == TAG_TEXT) {
+            u16 N = rd16(r);
+            if (r->i + N > r->n) { g_bad = 1; N = (u16)(r->n - r->i); }
+            ts->head += 3; ts->payload += N;
+            int b = 0;
+            while (b < HIST_N - 1 && N >= (1u << b)) b++;
+            g_hist[b]++;
+            if (N) str_add(r->p + r->i, N);
+            if (g_tree) { printf(" (%u) ", N); print_text(r->p + r->i, N, 48); putchar('\n'); }
+            r->i += N;
+
+        } else if (t == TAG_FRAC) {
+            ts->head += 5;
+            if (g_tree) putchar('\n');
+            dis_child(r, depth, "num");
+            dis_child(r, depth, "den");
+
+        } else if (t == TAG_SUP || t == TAG_SUB) {
+            ts->head += 3;
+            if (g_tree) putchar('\n');
+            dis_child(r, depth, "arg");
+
+        } else if (t == TAG_SQRT) {
+            ts->head += 5;
+            if (g_tree) putchar('\n');
+            dis_child(r, depth, "arg");
+            dis_child(r, depth, "indice");
+
+        } else if (t == TAG_BIGOP) {
+            ts->head += 7;
+            if (g_tree) putchar('\n');
+            dis_child(r, depth, "op");
+            dis_child(r, depth, "baixo");
+            dis_child(r, depth, "cima");
+
+        } else if (t == TAG_MAT) {
+            int rows = rd8(r), cols = rd8(r), delim = rd8(r);
+            if (rows < 0 || cols < 0 || delim < 0) return;
+            ts->head += 4 + 2u * (unsigned)(rows * cols);
+            if (g_tree) printf(" %dx%d delim=%c\n", rows, cols, delim ? delim : '-');
+            char label[24];
+            for (int k = 0; k < rows * cols; ++k) {
+                snprintf(label, sizeof label, "[%d,%d]", k / cols, k % cols);
+                dis_child(r, depth, label);
+            }
+
+        } else if (t == TAG_GLYPH) {
+            int g = rd8(r);
+            ts->head += 1; ts->payload += 1;
+            if (g_tree) {
+                if (g >= 0 && g < (int)(sizeof glyph_name / sizeof glyph_name[0])) printf(" %s\n", glyph_name[g]);
+                else printf(" id=%d\n", g);
+            }
+
+        } else if (t == TAG_NL || t == TAG_PAR) {
+            ts->head += 1;
+            if (g_tree) putchar('\n');
+
+        } else {
+            // o viewer também descarta tags desconhecidas (sem tamanho: não dá p/ seguir)
+            ts->head += 1;
+            g_bad = 1;
+            if (g_tree) printf(" tag 0x%02X desconhecida\n", t);
+            return;
+        }
+    }
+}
+
+/* ---------------- Relatório ---------------- */
+
+int main(int argc, char **argv){
+    if (argc < 2) { fprintf(stderr, "uso: %s out.bin [-t]\n", argv[0]); return 1; }
+    for (int a = 2; a < argc; ++a) if (strcmp(argv[a], "-t") == 0) g_tree = 1;
+
+    FILE *f = fopen(argv[1], "rb"); if (!f) { perror("in"); return 1; }
+    fseek(f, 0, SEEK_END); long n = ftell(f); rewind(f);
+    u8 *buf = (u8*)malloc(n ? (size_t)n : 1);
+    if (fread(buf, 1, (size_t)n, f) != (size_t)n) { perror("in"); return 1; }
+    fclose(f);
+
+    Rd r = { buf, (size_t)n, 0, 0 };
+    dis_seq(&r, 0);
+    if (g_tree) putchar('\n');
+
+    size_t head = 0, payload = 0;
+    for (int t = 0; t < 256; ++t) { head += g_tag[t].head; payload += g_tag[t].payload; }
+    size_t total = (size_t)n;
+
+    printf("%s: %zu bytes, %u nos, profundidade max %d%s\n",
+           argv[1], total, g_nodes, g_maxdepth, g_bad ? " (ARQUIVO TRUNCADO/INVALIDO)" : "");
+    if (r.i < r.n) printf("  %zu bytes nao lidos depois do fim da sequencia\n", r.n - r.i);
+
+    printf("\nBytes por tag:\n");
+    printf("  %-7s %7s %9s %9s %9s %6s\n", "tag", "nos", "cabecalho", "conteudo", "total", "%");
+    for (int t = 0; t < 256; ++t) {
+        TagStat *ts = &g_tag[t];
+        if (!ts->count) continue;
+        size_t tb = ts->head + ts->payload;
+        char name[8];
+        snprintf(name, sizeof name, "%s", tag_name((u8)t));
+        if (name[0] == '?') snprintf(name, sizeof name, "0x%02X", t);
+        printf("  %-7s %7u %9zu %9zu %9zu %5.1f%%\n", name, ts->count,
+               ts->head, ts->payload, tb, total ? 100.0 * tb / total : 0.0);
+    }
+    printf("  overhead de tags: %zu bytes, conteudo: %zu bytes (%.1f%% overhead)\n",
+           head, payload, (head + payload) ? 100.0 * head / (head + payload) : 0.0);
+
+    printf("\nTamanho dos TEXT:\n");
+    for (int b = 0; b < HIST_N; ++b) {
+        char lab[16];
+        if (b == 0) snprintf(lab, sizeof lab, "0");
+        else if (b == 1) snprintf(lab, sizeof lab, "1");
+        else if (b == HIST_N - 1) snprintf(lab, sizeof lab, "%u+", 1u << (b - 1));
+        else snprintf(lab, sizeof lab, "%u-%u", 1u << (b - 1), (1u << b) - 1);
+        printf("  %6s %7u\n", lab, g_hist[b]);
+    }
+
+    // compacta o hash e ordena por bytes gastos
+    size_t k = 0;
+    for (size_t i = 0; i < g_capstr; ++i) if (g_str[i].s && g_str[i].count > 1) g_str[k++] = g_str[i];
+    qsort(g_str, k, sizeof(Str), str_cmp);
+    printf("\nTextos repetidos (top 10 por bytes):\n");
+    if (!k) printf("  (nenhum)\n");
+    for (size_t i = 0; i < k && i < 10; ++i) {
+        printf("  %5ux %6zu bytes  ", g_str[i].count, str_cost(&g_str[i]));
+        print_text(g_str[i].s, g_str[i].len, 40);
+        putchar('\n');
+    }
+
+    free(g_str); free(buf);
+    return g_bad ? 2 : 0;
+}
@@ -1,5 +1,6 @@
 // tex2ce.c — conversor .tex -> bytecode p/ CE (AppVar)
-// Subset: \frac{A}{B}, ^{X}, _{Y}, \\ (quebra)
+// Subset: \frac{A}{B}, ^{X}, _{Y}, \\ (quebra), \sqrt, \sum/\lim com limites,
+//         \begin{pmatrix|bmatrix|vmatrix|matrix|array} ... \end{...}
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -29,100 +30,79 @@ static int match(Src *src, char c){ if(peek(src)==c){src->i++;return 1;} return
 
 static void parse_block(Src *src, Vec *out); // fwd
 
+// Tabelas densas Unicode -> charset TI-83+/84+/CE (0 = sem mapping).
+// Letras que a TI não tem (ã, õ, Α maiúsculo grego...) fazem "downgrade"
+// para a letra ASCII mais próxima.
+static const uint8_t ti_latin1[0x60] = {  // U+00A0..U+00FF
+     ' ', 0xBA,    0,    0,    0,    0,    0,    0,  // U+00A0  ¡
+    0xB8,    0,    0,    0,    0,    0,    0,    0,  // U+00A8  ¨
+       0,    0,    0,    0, 0xB6, 0xC3,    0,    0,  // U+00B0  ´ µ
+       0,    0,    0,    0,    0,    0,    0, 0xB9,  // U+00B8  ¿
+    0x8B, 0x8A, 0x8C,  'A', 0x8D,  'A',    0, 0xB2,  // U+00C0  À Á Â Ã Ä Å . Ç
+    0x93, 0x92, 0x94, 0x95, 0x9B, 0x9A, 0x9C, 0x9D,  // U+00C8  È É Ê Ë Ì Í Î Ï
+     'D', 0xB4, 0xA3, 0xA2, 0xA4,  'O', 0xA5,  '*',  // U+00D0  Ð Ñ Ò Ó Ô Õ Ö ×
+     'O', 0xAB, 0xAA, 0xAC, 0xAD,  'Y',    0,    0,  // U+00D8  Ø Ù Ú Û Ü Ý
+    0x8F, 0x8E, 0x90,  'a', 0x91,  'a',    0, 0xB3,  // U+00E0  à á â ã ä å . ç
+    0x97, 0x96, 0x98, 0x99, 0x9F, 0x9E, 0xA0, 0xA1,  // U+00E8  è é ê ë ì í î ï
+       0, 0xB5, 0xA7, 0xA6, 0xA8,  'o', 0xA9,  '/',  // U+00F0  . ñ ò ó ô õ ö ÷
+     'o', 0xAF, 0xAE, 0xB0, 0xB1,  'y',    0,  'y',  // U+00F8  ø ù ú û ü ý . ÿ
+};
+
+static const uint8_t ti_greek[0x39] = {  // U+0391..U+03C9
+     'A',  'B',    0, 0xBE,  'E',  'Z',  'H',    0,  // U+0391  Α Β Γ Δ Ε Ζ Η Θ
+     'I',  'K',    0,  'M',  'N',    0,  'O',    0,  // U+0399  Ι Κ Λ Μ Ν Ξ Ο Π
+     'P',    0, 0xC6,  'T',  'Y',    0,  'X',    0,  // U+03A1  Ρ . Σ Τ Υ Φ Χ Ψ
+    0xCA,    0,    0,    0,    0,    0,    0,    0,  // U+03A9  Ω
+    0xBB, 0xBC, 0xBD, 0xBF, 0xC0,    0,    0, 0x5B,  // U+03B1  α β γ δ ε ζ η θ
+       0,    0, 0xC2, 0xC3,    0,    0,  'o', 0xC4,  // U+03B9  ι κ λ μ ν ξ ο π
+    0xC5, 0xC7, 0xC7, 0xC8,    0, 0xC9,    0,    0,  // U+03C1  ρ ς σ τ υ φ χ ψ
+       0,                                            // U+03C9  ω
+};
+
 // Mapeia um codepoint Unicode para o byte do charset TI-83+/84+/CE
 static uint8_t ti_from_unicode(uint32_t cp) {
     // ASCII básico: passa direto
     if (cp < 0x80u) {
         return (uint8_t)cp;
     }
+    if (cp >= 0x00A0u && cp <= 0x00FFu) return ti_latin1[cp - 0x00A0u];
+    if (cp >= 0x0391u && cp <= 0x03C9u) return ti_greek[cp - 0x0391u];
+    if (cp >= 0x2080u && cp <= 0x2089u) return (uint8_t)(0x80u + (cp - 0x2080u)); // ₀..₉
 
-    // Acentos PT-BR que a TI tem
-    switch (cp) {
-        case 0x00C1: return 0x8A; // Á
-        case 0x00C0: return 0x8B; // À
-        case 0x00C2: return 0x8C; // Â
-        case 0x00C4: return 0x8D; // Ä
-
-        case 0x00E1: return 0x8E; // á
-        case 0x00E0: return 0x8F; // à
-        case 0x00E2: return 0x90; // â
-        case 0x00E4: return 0x91; // ä
-
-        case 0x00C9: return 0x92; // É
-        case 0x00C8: return 0x93; // È
-        case 0x00CA: return 0x94; // Ê
-        case 0x00CB: return 0x95; // Ë
-
-        case 0x00E9: return 0x96; // é
-        case 0x00E8: return 0x97; // è
-        case 0x00EA: return 0x98; // ê
-        case 0x00EB: return 0x99; // ë
-
-        case 0x00CD: return 0x9A; // Í
-        case 0x00CC: return 0x9B; // Ì
-        case 0x00CE: return 0x9C; // Î
-        case 0x00CF: return 0x9D; // Ï
-
-        case 0x00ED: return 0x9E; // í
-        case 0x00EC: return 0x9F; // ì
-
-        case 0x00D3: return 0xA2; // Ó
-        case 0x00D2: return 0xA3; // Ò
-        case 0x00D4: return 0xA4; // Ô
-        case 0x00D6: return 0xA5; // Ö
-
-        case 0x00F3: return 0xA6; // ó
-        case 0x00F2: return 0xA7; // ò
-        case 0x00F4: return 0xA8; // ô
-        case 0x00F6: return 0xA9; // ö
-
-        case 0x00DA: return 0xAA; // Ú
-        case 0x00D9: return 0xAB; // Ù
-        case 0x00DB: return 0xAC; // Û
-        case 0x00DC: return 0xAD; // Ü
-
-        case 0x00FA: return 0xAE; // ú
-        case 0x00F9: return 0xAF; // ù
-
-        case 0x00C7: return 0xB2; // Ç
-        case 0x00E7: return 0xB3; // ç
-    }
-
-    // Letras gregas no charset TI
-    switch (cp) {
-        case 0x03B1: return 0xBB; // α
-        case 0x03B2: return 0xBC; // β
-        case 0x03B3: return 0xBD; // γ
-        case 0x0394: return 0xBE; // Δ
-        case 0x03B4: return 0xBF; // δ
-        case 0x03B5: return 0xC0; // ε
-        case 0x03B8: return 0x5B; // θ
-        case 0x03BB: return 0xC2; // λ
-        case 0x03BC: return 0xC3; // μ
-        case 0x03C0: return 0xC4; // π
-        case 0x03C1: return 0xC5; // ρ
-        case 0x03A3: return 0xC6; // Σ
-        case 0x03C3: return 0xC7; // σ
-        case 0x03C4: return 0xC8; // τ
-        case 0x03C6: return 0xC9; // φ
-        case 0x03A9: return 0xCA; // Ω
-    }
-
-    // Coisas que a TI NÃO tem (ã, õ, etc.) – faz “downgrade”
+    // pontuação tipográfica -> ASCII
     switch (cp) {
-        case 0x00E3: return 'a'; // ã
-        case 0x00C3: return 'A'; // Ã
-        case 0x00F5: return 'o'; // õ
-        case 0x00D5: return 'O'; // Õ
+        case 0x2013: case 0x2014: case 0x2212: return '-';  // – — −
+        case 0x2018: case 0x2019: return '\'';              // ‘ ’
+        case 0x201C: case 0x201D: return '"';               // “ ”
+        case 0x03D5: return 0xC9;                           // ϕ
     }
 
     return 0; // sem mapping
 }
 
+// Símbolos que a fonte da TI não tem: viram GLYPH (0x0A id), um sprite
+// desenhado pelo viewer. A ordem define o id e deve bater com src/main.c.
+static const uint32_t glyph_cp[] = {
+    0x222B, // ∫
+    0x2211, // ∑
+    0x221A, // √
+    0x221E, // ∞
+    0x2202, // ∂
+    0x2264, // ≤
+    0x2265, // ≥
+    0x2260, // ≠
+};
+
+static int glyph_from_unicode(uint32_t cp){
+    for (int g = 0; g < (int)(sizeof glyph_cp / sizeof glyph_cp[0]); ++g)
+        if (glyph_cp[g] == cp) return g;
+    return -1;
+}
+
 static void emit_text_ascii(Vec *out, const char *beg, size_t n){
     if (!n) return;
 
-    // buffer temporário: UTF-8 até 3 bytes → 1 char TI
+    // buffer temporário: UTF-8 até 3 bytes → 1 char TI (ou 1 GLYPH)
     uint8_t *tmp = (uint8_t*)malloc(n * 2);
     size_t m = 0;
 
@@ -153,6 +133,14 @@ static void emit_text_ascii(Vec *out, const char *beg, size_t n){
 
         uint8_t outch;
 
+        // símbolo com sprite: fecha o texto pendente e emite GLYPH
+        int g = glyph_from_unicode(cp);
+        if (g >= 0) {
+            if (m) { put_u8(out, 0x01); put_u16(out, (u16)m); vec_put(out, tmp, m); m = 0; }
+            put_u8(out, 0x0A); put_u8(out, (u8)g);
+            continue;
+        }
+
         // Tab vira espaço, pra não quebrar layout
         if (cp == '\t') {
             outch = ' ';
@@ -169,9 +157,11 @@ static void emit_text_ascii(Vec *out, const char *beg, size_t n){
         tmp[m++] = outch;
     }
 
-    put_u8(out, 0x01);
-    put_u16(out, (u16)m);
-    vec_put(out, tmp, m);
+    if (m) {
+        put_u8(out, 0x01);
+        put_u16(out, (u16)m);
+        vec_put(out, tmp, m);
+    }
     free(tmp);
 }
 
@@ -189,6 +179,174 @@ static void parse_group_into(Src *src, Vec *payload){
 }
 static void emit_text(Vec *out, const char *beg, size_t n){ emit_text_ascii(out,beg,n); }
 
+static void skip_blanks(Src *src){
+    while (src->i < src->n && (src->s[src->i] == ' ' || src->s[src->i] == '\t')) src->i++;
+}
+
+// Quantos argumentos {..} o comando leva (os que o parse_block consome)
+static int cmd_nargs(const char *name, size_t k){
+    if (k == 4 && strncmp(name, "frac", 4) == 0) return 2;
+    if (k == 4 && strncmp(name, "sqrt", 4) == 0) return 1;
+    return 0;
+}
+
+// Avança sobre um argumento: {grupo} (com as chaves), \comando junto com os
+// argumentos dele (\frac{a}{b}, \sqrt[n]{x}) ou um caractere UTF-8 inteiro.
+static void skip_arg(Src *src){
+    skip_blanks(src);
+    if (src->i >= src->n) return;
+    if (match(src, '{')) {
+        int depth = 1;
+        while (src->i < src->n && depth > 0) {
+            char c = src->s[src->i++];
+            if (c == '{') depth++; else if (c == '}') depth--;
+        }
+    } else if (match(src, '\\')) {
+        const char *name = src->s + src->i;
+        if (isalpha(peek(src))) while (isalpha(peek(src))) src->i++;
+        else if (src->i < src->n) src->i++;
+        int nargs = cmd_nargs(name, (size_t)(src->s + src->i - name));
+        if (nargs && peek(src) == '[')
+            while (src->i < src->n && get(src) != ']') {}
+        while (nargs-- > 0) skip_arg(src);
+    } else {
+        src->i++;
+        while (src->i < src->n && ((unsigned char)src->s[src->i] & 0xC0) == 0x80) src->i++;
+    }
+}
+
+// ^X / _X / \sqrt X: grupo {...}, um comando com seus argumentos (\pi,
+// \frac{a}{b}) ou um único caractere. Brancos antes do argumento são pulados.
+static void parse_script_into(Src *src, Vec *child){
+    skip_blanks(src);
+    if (peek(src) == '{') { parse_group_into(src, child); return; }
+    size_t a = src->i;
+    skip_arg(src);
+    Src inner = {.s = src->s + a, .i = 0, .n = src->i - a};
+    parse_block(&inner, child);
+}
+
+// src->s+src->i começa com o comando `name` inteiro (não só prefixo)?
+static int is_cmd(Src *src, const char *name){
+    size_t k = strlen(name);
+    if (src->i + k > src->n || strncmp(src->s + src->i, name, k) != 0) return 0;
+    return !(src->i + k < src->n && isalpha((unsigned char)src->s[src->i + k]));
+}
+
+// \sum _{i}, \sum\limits_{i}^{n}: pula brancos e \limits/\nolimits antes dos
+// limites. Devolve onde parar se não vier limite (brancos ficam p/ o texto).
+static size_t skip_limits(Src *src){
+    size_t keep = src->i;
+    for (;;) {
+        skip_blanks(src);
+        if (peek(src) != '\\') return keep;
+        src->i++;
+        if (is_cmd(src, "limits")) src->i += 6;
+        else if (is_cmd(src, "nolimits")) src->i += 8;
+        else { src->i--; return keep; }
+        keep = src->i;
+    }
+}
+
+static void put_child(Vec *out, Vec *child){
+    put_u16(out, (u16)child->len); vec_put(out, child->buf, child->len);
+}
+
+// Ambientes de matriz -> delimitador desenhado pelo viewer
+static const struct { const char *env; u8 delim; } mat_env[] = {
+    {"pmatrix", '('}, {"bmatrix", '['}, {"vmatrix", '|'},
+    {"matrix",  0  }, {"array",   0  },
+    {NULL, 0}
+};
+
+static int is_blank(char c){ return c==' ' || c=='\t' || c=='\r' || c=='\n'; }
+
+// Corpo de \begin{env} ... \end{env}: células separadas por & e linhas por \\.
+// src->i já está depois de "\begin{env}". Emite MATRIX:
+//   0x08 rows cols delim, e rows*cols vezes (u16 len + sequência)
+static void parse_matrix(Src *src, Vec *out, u8 delim){
+    enum { MAX_CELLS = 255 };
+    Vec cells[MAX_CELLS]; u8 crow[MAX_CELLS], ccol[MAX_CELLS];
+    int nc = 0, row = 0, col = 0, cols = 0, dropped = 0;
+
+    // array{cc|c}: especificação de colunas é ignorada
+    if (peek(src) == '{') {
+        while (src->i < src->n && get(src) != '}') {}
+    }
+
+    size_t cstart = src->i, j = src->i;
+    int depth = 0, env = 0, done = 0;
+    while (!done) {
+        int end_cell = 0, end_row = 0;
+        if (j >= src->n) { end_cell = 1; done = 1; }
+        else {
+            char c = src->s[j];
+            if (c == '{') depth++;
+            else if (c == '}') depth--;
+            if (c == '\\' && depth == 0) {
+                if (strncmp(src->s + j, "\\begin", 6) == 0) env++;
+                else if (strncmp(src->s + j, "\\end", 4) == 0) {
+                    if (env == 0) { end_cell = 1; done = 1; }
+                    else env--;
+                } else if (env == 0 && j + 1 < src->n && src->s[j+1] == '\\') {
+                    end_cell = 1; end_row = 1;
+                }
+            } else if (c == '&' && depth == 0 && env == 0) {
+                end_cell = 1;
+            }
+        }
+        if (!end_cell) { j++; continue; }
+
+        // célula [cstart, j) sem brancos nas pontas
+        size_t a = cstart, b = j;
+        while (a < b && is_blank(src->s[a])) a++;
+        while (b > a && is_blank(src->s[b-1])) b--;
+        // "\\" final antes do \end não abre linha vazia
+        int trailing = done && col == 0 && a == b;
+        // rows/cols vão em u8: passado o limite, o resto é descartado (com aviso)
+        if (!trailing && nc == MAX_CELLS) dropped++;
+        if (!trailing && nc < MAX_CELLS) {
+            Src inner = {.s = src->s + a, .i = 0, .n = b - a};
+            cells[nc] = (Vec){0};
+            parse_block(&inner, &cells[nc]);
+            crow[nc] = (u8)row; ccol[nc] = (u8)col; nc++;
+            if (col + 1 > cols) cols = col + 1;
+        }
+        if (end_row) { row++; col = 0; j += 2; }
+        else if (!done) { col++; j++; }
+        cstart = j;
+    }
+    int rows = nc ? crow[nc-1] + 1 : 0;
+    // corte no meio de uma linha: descarta a linha incompleta inteira
+    if (dropped && rows > 1 && ccol[nc-1] + 1 < cols) {
+        while (nc && crow[nc-1] == rows - 1) { free(cells[--nc].buf); dropped++; }
+        rows--;
+    }
+    if (dropped)
+        fprintf(stderr, "aviso: matriz com mais de %d celulas; %d descartadas (ficou %dx%d)\n",
+                MAX_CELLS, dropped, rows, cols);
+
+    // consome "\end{env}"
+    src->i = j;
+    if (src->i < src->n) {
+        src->i += 4;
+        if (peek(src) == '{') while (src->i < src->n && get(src) != '}') {}
+    }
+
+    put_u8(out, 0x08);                               // MATRIX
+    put_u8(out, (u8)rows); put_u8(out, (u8)cols); put_u8(out, delim);
+    int k = 0;
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            if (k < nc && crow[k] == r && ccol[k] == c) {
+                put_child(out, &cells[k]); free(cells[k].buf); k++;
+            } else {
+                put_u16(out, 0);                     // célula ausente
+            }
+        }
+    }
+}
+
 static void parse_block(Src *src, Vec *out){
     const char *tstart = src->s + src->i; size_t tlen = 0;
     while (src->i < src->n) {
@@ -244,6 +402,69 @@ static void parse_block(Src *src, Vec *out){
                 put_u8(out, 0x05);                       // NEWLINE
                 tstart = src->s + src->i;
 
+            } else if (is_cmd(src, "sqrt")) {
+                src->i += 4;
+                // \sqrt[n]{x}: SQRT leva radicando e índice (vazio sem [n])
+                Vec idx = {0}, rad = {0};
+                if (match(src, '[')) {
+                    size_t a = src->i;
+                    while (src->i < src->n && src->s[src->i] != ']') src->i++;
+                    Src inner = {.s = src->s + a, .i = 0, .n = src->i - a};
+                    parse_block(&inner, &idx);
+                    match(src, ']');
+                }
+                parse_script_into(src, &rad);
+                put_u8(out, 0x07);                        // SQRT
+                put_child(out, &rad); put_child(out, &idx);
+                free(rad.buf); free(idx.buf);
+                tstart = src->s + src->i;
+
+            } else if (is_cmd(src, "begin")) {
+                src->i += 5;
+                u8 delim = 0; int found = 0;
+                if (peek(src) == '{') {
+                    size_t a = src->i + 1, b = a;
+                    while (b < src->n && src->s[b] != '}') b++;
+                    for (int e = 0; mat_env[e].env; ++e) {
+                        if (b - a == strlen(mat_env[e].env) &&
+                            strncmp(src->s + a, mat_env[e].env, b - a) == 0) {
+                            delim = mat_env[e].delim; found = 1; break;
+                        }
+                    }
+                    if (found) src->i = b + 1;
+                }
+                if (found) {
+                    parse_matrix(src, out, delim);
+                } else {
+                    // ambiente desconhecido: literal, como os outros comandos
+                    emit_text(out, "\\begin", 6);
+                }
+                tstart = src->s + src->i;
+
+            } else if (is_cmd(src, "sum") || is_cmd(src, "int") || is_cmd(src, "lim")) {
+                // operador grande: com limites vira BIGOP, sem limites é texto
+                const char *op = (src->s[src->i] == 's') ? "∑"
+                               : (src->s[src->i] == 'i') ? "∫" : "lim";
+                src->i += 3;
+                Vec lo = {0}, up = {0};
+                for (int t = 0; t < 2; ++t) {
+                    size_t keep = skip_limits(src);
+                    if (match(src, '_'))      { free(lo.buf); lo = (Vec){0}; parse_script_into(src, &lo); }
+                    else if (match(src, '^')) { free(up.buf); up = (Vec){0}; parse_script_into(src, &up); }
+                    else { src->i = keep; break; }
+                }
+                if (lo.len || up.len) {
+                    Vec opv = {0};
+                    emit_text(&opv, op, strlen(op));
+                    put_u8(out, 0x09);                   // BIGOP: op, baixo, cima
+                    put_child(out, &opv); put_child(out, &lo); put_child(out, &up);
+                    free(opv.buf);
+                } else {
+                    emit_text(out, op, strlen(op));
+                }
+                free(lo.buf); free(up.buf);
+                tstart = src->s + src->i;
+
             } else {
                 // aliases: mapeia alguns \comandos para ASCII
                 static const struct { const char *cmd, *subst; } alias[] = {
@@ -277,15 +498,22 @@ static void parse_block(Src *src, Vec *out){
                     {"Big",        ""},   // tamanhos ignorados
                     {"big",        ""},
 
-                    {"int",        "integral"}, // TODO mapear ∫
                     {"quad",       " "},
 
+                    // símbolos com sprite no viewer (GLYPH)
+                    {"infty",      "∞"},
+                    {"partial",    "∂"},
+                    {"surd",       "√"},
+                    {"leq",        "≤"},
+                    {"le",         "≤"},
+                    {"geq",        "≥"},
+                    {"ge",         "≥"},
+                    {"neq",        "≠"},
+                    {"ne",         "≠"},
+
                     // extras uteis
                     {"cdot",       "*"},
                     {"times",      "*"},
-                    {"leq",        "<="},
-                    {"geq",        ">="},
-                    {"neq",        "!="},
                     {"pm",         "+/-"},
                     {NULL, NULL}
                 };
@@ -315,14 +543,19 @@ static void parse_block(Src *src, Vec *out){
             emit_text(out, tstart, tlen); tlen = 0; get(src);
             u8 tag = (c=='^') ? 0x03 : 0x04;
             Vec child = {0};
-            if (match(src,'{')) { src->i--; parse_group_into(src, &child); }
-            else { put_u8(&child,0x01); put_u16(&child,1); put_u8(&child,(u8)get(src)); }
-            put_u8(out, tag); put_u16(out, (u16)child.len); vec_put(out, child.buf, child.len);
+            parse_script_into(src, &child);
+            put_u8(out, tag); put_child(out, &child);
             free(child.buf);
             tstart = src->s + src->i;
 
-        } else if (c == '}') {                          // fim de grupo
-            break;
+        } else if (c == '{') {                          // grupo solto: só agrupa
+            emit_text(out, tstart, tlen); tlen = 0;
+            parse_group_into(src, out);
+            tstart = src->s + src->i;
+
+        } else if (c == '}') {                          // '}' sem par: descarta
+            emit_text(out, tstart, tlen); tlen = 0; get(src);
+            tstart = src->s + src->i;
 
         } else {                                        // texto plano
             get(src); tlen++;
@@ -332,18 +565,122 @@ static void parse_block(Src *src, Vec *out){
 }
 
 
+/* ---------------- Coalescência (peephole) ----------------
+ * Reescreve o bytecode já gerado: junta TEXT vizinhos, descarta TEXT vazio
+ * e reduz uma sequência de NL/PAR a uma quebra só (PAR vence NL). Quebras
+ * no começo e no fim do documento somem; dentro de caixas (fração, índice,
+ * raiz, célula...) também, porque o viewer não quebra linha ali.
+ * Cada nó a menos é um malloc, uma medida e um DrawString a menos no viewer.
+ */
+typedef struct { size_t in, out; } NodeCount;
+static NodeCount g_nodes;
+
+typedef struct {
+    Vec *out;
+    Vec text;   // texto pendente (ainda sem cabeçalho)
+    u8  brk;    // quebra pendente: 0, 0x05 (NL) ou 0x06 (PAR)
+    int any;    // já saiu algum nó nesta sequência
+} Coal;
+
+static void coal_text(Coal *c){
+    if (!c->text.len) return;
+    put_u8(c->out, 0x01);
+    put_u16(c->out, (u16)c->text.len);
+    vec_put(c->out, c->text.buf, c->text.len);
+    c->text.len = 0;
+    c->any = 1;
+    g_nodes.out++;
+}
+
+static void coal_break(Coal *c){
+    if (!c->brk) return;
+    put_u8(c->out, c->brk);
+    c->brk = 0;
+    g_nodes.out++;
+}
+
+static void coalesce(const u8 *p, size_t n, Vec *out, int top);
+
+static void coal_child(const u8 *p, size_t *i, Vec *out){
+    u16 L = (u16)(p[*i] | (p[*i+1] << 8));
+    *i += 2;
+    Vec child = {0};
+    coalesce(p + *i, L, &child, 0);
+    *i += L;
+    put_child(out, &child);
+    free(child.buf);
+}
+
+static void coalesce(const u8 *p, size_t n, Vec *out, int top){
+    Coal c = { .out = out };
+    size_t i = 0;
+
+    while (i < n) {
+        u8 t = p[i++];
+        if (t == 0xFF) break;                           // END: o main reemite
+        g_nodes.in++;
+
+        if (t == 0x01) {                                // TEXT
+            u16 N = (u16)(p[i] | (p[i+1] << 8));
+            i += 2;
+            if (N) {
+                coal_break(&c);
+                if (c.text.len + N > 0xFFFF) coal_text(&c);
+                vec_put(&c.text, p + i, N);
+            }
+            i += N;
+            continue;
+        }
+
+        if (t == 0x05 || t == 0x06) {                   // NL / PAR
+            if (!top) continue;
+            coal_text(&c);
+            if (c.any) c.brk = (t == 0x06 || c.brk == 0x06) ? 0x06 : 0x05;
+            continue;
+        }
+
+        coal_text(&c);
+        coal_break(&c);
+        put_u8(out, t);
+        g_nodes.out++;
+        c.any = 1;
+
+        if (t == 0x02 || t == 0x07) {                   // FRAC / SQRT (+ índice)
+            coal_child(p, &i, out); coal_child(p, &i, out);
+        } else if (t == 0x03 || t == 0x04) {            // SUP / SUB
+            coal_child(p, &i, out);
+        } else if (t == 0x09) {                         // BIGOP
+            coal_child(p, &i, out); coal_child(p, &i, out); coal_child(p, &i, out);
+        } else if (t == 0x08) {                         // MATRIX
+            u8 rows = p[i], cols = p[i+1];
+            vec_put(out, p + i, 3); i += 3;
+            for (int k = 0; k < rows * cols; ++k) coal_child(p, &i, out);
+        } else if (t == 0x0A) {                         // GLYPH
+            put_u8(out, p[i++]);
+        } else {
+            // não deveria acontecer: copia o resto como está
+            vec_put(out, p + i, n - i);
+            break;
+        }
+    }
+    coal_text(&c);                                      // quebra final some
+    free(c.text.buf);
+}
+
 int main(int argc, char **argv){
     if(argc<3){ fprintf(stderr,"uso: %s in.tex out.bin\n", argv[0]); return 1; }
     FILE *f=fopen(argv[1],"rb"); if(!f){perror("in");return 1;}
     fseek(f,0,SEEK_END); long n=ftell(f); rewind(f);
     char *buf=(char*)malloc(n+1); fread(buf,1,n,f); buf[n]=0; fclose(f);
 
-    Src src={.s=buf,.i=0,.n=(size_t)n}; Vec out={0};
-    parse_block(&src,&out); put_u8(&out,0xFF);
+    Src src={.s=buf,.i=0,.n=(size_t)n}; Vec raw={0}, out={0};
+    parse_block(&src,&raw);
+    coalesce(raw.buf, raw.len, &out, 1); put_u8(&out,0xFF);
 
     FILE *g=fopen(argv[2],"wb"); if(!g){perror("out");return 1;}
     fwrite(out.buf,1,out.len,g); fclose(g);
-    fprintf(stderr,"OK: %zu bytes\n", out.len);
-    free(out.buf); free(buf);
+    fprintf(stderr,"OK: %zu bytes (%zu antes da coalescencia), nos: %zu -> %zu\n",
+            out.len, raw.len + 1, g_nodes.in, g_nodes.out);
+    free(raw.buf); free(out.buf); free(buf);
     return 0;
 }